@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ScavengerCoverCore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ScavengerCover;
+
+namespace
+{
+	const float MaxCoverAngle = 30.0f;
+	const int NumInputs = 4096;
+
+	// The checks as the character made them before the core, an acos per angle
+	float AngleBetween(const FVec3& A, const FVec3& B)
+	{
+		return std::acos(Dot(A, B)) * 180.0f / 3.14159265f;
+	}
+
+	bool OldIsEnteringCover(const FVec3& Move, const FVec3& SurfaceNormal)
+	{
+		return AngleBetween(Move, -SurfaceNormal) < MaxCoverAngle;
+	}
+
+	bool OldIsFacingRight(const FVec3& Move, const FVec3& Right)
+	{
+		return AngleBetween(Move, Right) < AngleBetween(Move, -Right);
+	}
+
+	struct FInput
+	{
+		FVec3 Move;
+		FVec3 Normal;
+	};
+
+	// Input and wall directions on the ground plane, the way the character sees them
+	std::vector<FInput> MakeInputs()
+	{
+		std::mt19937 Random(1234);
+		std::uniform_real_distribution<float> Yaw(-3.14159265f, 3.14159265f);
+
+		std::vector<FInput> Inputs(NumInputs);
+		for (FInput& Input : Inputs)
+		{
+			const float MoveYaw = Yaw(Random);
+			// Mostly facing the wall, so both sides of the threshold are hit
+			const float NormalYaw = MoveYaw + 3.14159265f + Yaw(Random) * 0.5f;
+			Input.Move = FVec3{ std::cos(MoveYaw), std::sin(MoveYaw), 0.0f };
+			Input.Normal = FVec3{ std::cos(NormalYaw), std::sin(NormalYaw), 0.0f };
+		}
+		return Inputs;
+	}
+
+	template <typename CheckType>
+	double Time(const std::vector<FInput>& Inputs, long Iterations, CheckType Check, long& OutHits)
+	{
+		long Hits = 0;
+		const auto Start = std::chrono::steady_clock::now();
+		for (long i = 0; i < Iterations; i++)
+		{
+			const FInput& Input = Inputs[i % NumInputs];
+			Hits += Check(Input) ? 1 : 0;
+		}
+		const auto End = std::chrono::steady_clock::now();
+
+		OutHits = Hits;
+		return std::chrono::duration<double, std::nano>(End - Start).count() / Iterations;
+	}
+
+	// Times both versions of a check and counts inputs they disagree on, which should only be
+	// the odd one rounding differently right on the threshold
+	template <typename OldType, typename NewType>
+	bool Compare(const char* Name, const std::vector<FInput>& Inputs, long Iterations, OldType Old, NewType New)
+	{
+		long OldHits = 0;
+		long NewHits = 0;
+		const double OldNs = Time(Inputs, Iterations, Old, OldHits);
+		const double NewNs = Time(Inputs, Iterations, New, NewHits);
+
+		int Mismatches = 0;
+		for (const FInput& Input : Inputs) Mismatches += Old(Input) != New(Input) ? 1 : 0;
+
+		std::printf("%-16s acos %6.2f ns  dot %6.2f ns  %5.1fx  hits %ld/%ld  mismatches %d/%d\n",
+			Name, OldNs, NewNs, NewNs > 0.0 ? OldNs / NewNs : 0.0, NewHits, Iterations, Mismatches, NumInputs);
+
+		return Mismatches <= NumInputs / 1000;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const long Iterations = argc > 1 ? std::atol(argv[1]) : 50000000L;
+	if (Iterations <= 0)
+	{
+		std::printf("Usage: %s [iterations]\n", argv[0]);
+		return 2;
+	}
+
+	const std::vector<FInput> Inputs = MakeInputs();
+	const float CosMaxCoverAngle = CosFromDegrees(MaxCoverAngle);
+	const FVec3 Right{ 0.0f, 1.0f, 0.0f };
+
+	bool Agree = true;
+	Agree &= Compare("IsEnteringCover", Inputs, Iterations,
+		[](const FInput& Input) { return OldIsEnteringCover(Input.Move, Input.Normal); },
+		[CosMaxCoverAngle](const FInput& Input) { return IsEnteringCover(Input.Move, Input.Normal, CosMaxCoverAngle); });
+	Agree &= Compare("IsFacingRight", Inputs, Iterations,
+		[Right](const FInput& Input) { return OldIsFacingRight(Input.Move, Right); },
+		[Right](const FInput& Input) { return IsFacingRight(Input.Move, Right); });
+
+	if (!Agree)
+	{
+		std::printf("Dot product checks disagree with the acos checks\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ScavengerCoverCore.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace ScavengerCover;
+
+static int Failures = 0;
+
+#define CHECK(Expr) \
+	do \
+	{ \
+		if (!(Expr)) \
+		{ \
+			std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Expr); \
+			Failures++; \
+		} \
+	} while (0)
+
+namespace
+{
+	const FVec3 Forward{ 1.0f, 0.0f, 0.0f };
+	const FVec3 Back{ -1.0f, 0.0f, 0.0f };
+	const FVec3 Right{ 0.0f, 1.0f, 0.0f };
+	const FVec3 Up{ 0.0f, 0.0f, 1.0f };
+	const FVec3 Zero{ 0.0f, 0.0f, 0.0f };
+
+	// Unit vector on the ground plane, Degrees off Forward towards Right
+	FVec3 FromYaw(float Degrees)
+	{
+		const float Radians = Degrees * 3.14159265f / 180.0f;
+		return FVec3{ std::cos(Radians), std::sin(Radians), 0.0f };
+	}
+
+	// Answers traces by which side of the origin they start on, and records them
+	class FFakeWorld : public ICoverWorldQuery
+	{
+	public:
+		ECoverHit Left = ECoverHit::Cover;
+		ECoverHit RightSide = ECoverHit::Cover;
+		// Anything starting above this height
+		float HeadHeight = 1000.0f;
+		ECoverHit Head = ECoverHit::None;
+
+		mutable std::vector<FVec3> Starts;
+		mutable std::vector<FVec3> Ends;
+
+		virtual ECoverHit TraceStatic(const FVec3& Start, const FVec3& End) const override
+		{
+			Starts.push_back(Start);
+			Ends.push_back(End);
+			if (Start.Z >= HeadHeight) return Head;
+			return Start.Y < 0.0f ? Left : RightSide;
+		}
+	};
+
+	void TestCosFromDegrees()
+	{
+		CHECK(std::fabs(CosFromDegrees(0.0f) - 1.0f) < 1e-6f);
+		CHECK(std::fabs(CosFromDegrees(60.0f) - 0.5f) < 1e-5f);
+		CHECK(std::fabs(CosFromDegrees(90.0f)) < 1e-5f);
+		CHECK(std::fabs(CosFromDegrees(180.0f) + 1.0f) < 1e-6f);
+	}
+
+	void TestIsEnteringCover()
+	{
+		const float Cos30 = CosFromDegrees(30.0f);
+		// The wall faces back at a character walking forward into it
+		CHECK(IsEnteringCover(Forward, Back, Cos30));
+		CHECK(IsEnteringCover(FromYaw(29.0f), Back, Cos30));
+		CHECK(IsEnteringCover(FromYaw(-29.0f), Back, Cos30));
+		CHECK(!IsEnteringCover(FromYaw(31.0f), Back, Cos30));
+		CHECK(!IsEnteringCover(FromYaw(-31.0f), Back, Cos30));
+		// Drive-bys along the wall and backing away don't count
+		CHECK(!IsEnteringCover(Right, Back, Cos30));
+		CHECK(!IsEnteringCover(Back, Back, Cos30));
+		// No input is never a way in
+		CHECK(!IsEnteringCover(Zero, Back, Cos30));
+
+		// A wider angle lets in what a narrow one refused
+		CHECK(IsEnteringCover(FromYaw(44.0f), Back, CosFromDegrees(45.0f)));
+		CHECK(!IsEnteringCover(FromYaw(44.0f), Back, CosFromDegrees(40.0f)));
+	}
+
+	void TestIsLeavingCover()
+	{
+		const float Cos30 = CosFromDegrees(30.0f);
+		// In cover facing forward into the wall, pulling back leaves
+		CHECK(IsLeavingCover(Back, Forward, Cos30));
+		CHECK(IsLeavingCover(FromYaw(180.0f - 25.0f), Forward, Cos30));
+		CHECK(!IsLeavingCover(FromYaw(180.0f - 35.0f), Forward, Cos30));
+		CHECK(!IsLeavingCover(Forward, Forward, Cos30));
+		CHECK(!IsLeavingCover(Right, Forward, Cos30));
+		CHECK(!IsLeavingCover(Zero, Forward, Cos30));
+	}
+
+	void TestTickHold()
+	{
+		int Timer = 0;
+
+		// Completes on the HoldTime'th held tick and starts again
+		CHECK(!TickHold(true, Timer, 3));
+		CHECK(!TickHold(true, Timer, 3));
+		CHECK(TickHold(true, Timer, 3));
+		CHECK(Timer == 0);
+		CHECK(!TickHold(true, Timer, 3));
+		CHECK(Timer == 1);
+
+		// Letting go pauses the count rather than resetting it
+		CHECK(!TickHold(false, Timer, 3));
+		CHECK(Timer == 1);
+		CHECK(!TickHold(true, Timer, 3));
+		CHECK(TickHold(true, Timer, 3));
+
+		// A hold time of one or less fires on every held tick
+		Timer = 0;
+		CHECK(TickHold(true, Timer, 1));
+		CHECK(TickHold(true, Timer, 0));
+		CHECK(!TickHold(false, Timer, 0));
+	}
+
+	void TestMoveBlockedAtEdge()
+	{
+		// Held at the left edge, only moving further left is blocked
+		CHECK(IsMoveBlockedAtEdge(-Right, Right, true, false));
+		CHECK(!IsMoveBlockedAtEdge(Right, Right, true, false));
+		CHECK(!IsMoveBlockedAtEdge(Forward, Right, true, false));
+
+		CHECK(IsMoveBlockedAtEdge(Right, Right, false, true));
+		CHECK(!IsMoveBlockedAtEdge(-Right, Right, false, true));
+
+		CHECK(!IsMoveBlockedAtEdge(Right, Right, false, false));
+		CHECK(!IsMoveBlockedAtEdge(-Right, Right, false, false));
+	}
+
+	void TestIsFacingRight()
+	{
+		CHECK(IsFacingRight(Right, Right));
+		CHECK(IsFacingRight(FromYaw(80.0f), Right));
+		CHECK(!IsFacingRight(-Right, Right));
+		CHECK(!IsFacingRight(FromYaw(-80.0f), Right));
+		// Straight in or no input keeps facing left
+		CHECK(!IsFacingRight(Forward, Right));
+		CHECK(!IsFacingRight(Zero, Right));
+	}
+
+	void TestProbeEdges()
+	{
+		FFakeWorld World;
+		World.Left = ECoverHit::Blocking;
+		World.RightSide = ECoverHit::Cover;
+
+		const FEdgeProbe Probe = ProbeEdges(World, Zero, Right, Forward, 40.0f, 100.0f);
+		CHECK(Probe.Left == ECoverHit::Blocking);
+		CHECK(Probe.Right == ECoverHit::Cover);
+
+		// One trace either side, HalfWidth out and SenseDistance into the wall
+		CHECK(World.Starts.size() == 2);
+		CHECK(World.Starts[0].Y == -40.0f && World.Ends[0].X == 100.0f && World.Ends[0].Y == -40.0f);
+		CHECK(World.Starts[1].Y == 40.0f && World.Ends[1].X == 100.0f && World.Ends[1].Y == 40.0f);
+	}
+
+	void TestEdgeState()
+	{
+		FEdgeState State;
+		CHECK(!State.IsOnEdge());
+		CHECK(!State.IsOffCover());
+
+		// Anything but cover under a side holds the character there
+		ApplyEdgeProbe(FEdgeProbe{ ECoverHit::Cover, ECoverHit::Cover }, State);
+		CHECK(!State.OnEdgeLeft && !State.OnEdgeRight && !State.IsOnEdge());
+
+		ApplyEdgeProbe(FEdgeProbe{ ECoverHit::Blocking, ECoverHit::Cover }, State);
+		CHECK(State.OnEdgeLeft && !State.OnEdgeRight);
+		CHECK(State.IsOnEdge() && !State.IsOffCover());
+
+		ApplyEdgeProbe(FEdgeProbe{ ECoverHit::None, ECoverHit::None }, State);
+		CHECK(State.IsOffCover());
+
+		// Only open space next to the character lets it pop out, a blocking wall doesn't
+		ApplyPopOutProbe(FEdgeProbe{ ECoverHit::None, ECoverHit::Blocking }, State);
+		CHECK(State.AdjustedLeft && !State.AdjustedRight);
+		ApplyPopOutProbe(FEdgeProbe{ ECoverHit::Cover, ECoverHit::None }, State);
+		CHECK(!State.AdjustedLeft && State.AdjustedRight);
+
+		// The two halves are independent
+		CHECK(State.IsOffCover());
+	}
+
+	void TestIsCoverStandable()
+	{
+		FFakeWorld World;
+		World.HeadHeight = 60.0f;
+
+		World.Head = ECoverHit::None;
+		CHECK(!IsCoverStandable(World, Zero, Up, Forward, 60.0f, 100.0f));
+		CHECK(World.Starts.back().Z == 60.0f && World.Ends.back().X == 100.0f);
+
+		// Anything in front of the head is tall enough, cover or not
+		World.Head = ECoverHit::Blocking;
+		CHECK(IsCoverStandable(World, Zero, Up, Forward, 60.0f, 100.0f));
+		World.Head = ECoverHit::Cover;
+		CHECK(IsCoverStandable(World, Zero, Up, Forward, 60.0f, 100.0f));
+	}
+
+	void TestDash()
+	{
+		const int Duration = 3;
+		const int Cooldown = 4;
+
+		int CooldownTimer = Cooldown;
+		CHECK(IsDashReady(CooldownTimer, Cooldown));
+
+		// A dash lasts Duration ticks
+		int Timer = 0;
+		CHECK(!TickDash(Timer, Duration));
+		CHECK(!TickDash(Timer, Duration));
+		CHECK(TickDash(Timer, Duration));
+
+		// Then cools down for Cooldown ticks and stays ready
+		CooldownTimer = 0;
+		for (int i = 0; i < Cooldown; i++)
+		{
+			CHECK(!IsDashReady(CooldownTimer, Cooldown));
+			TickDashCooldown(CooldownTimer, Cooldown);
+		}
+		CHECK(IsDashReady(CooldownTimer, Cooldown));
+		TickDashCooldown(CooldownTimer, Cooldown);
+		CHECK(CooldownTimer == Cooldown);
+
+		// No cooldown is always ready
+		CHECK(IsDashReady(0, 0));
+	}
+}
+
+int main()
+{
+	TestCosFromDegrees();
+	TestIsEnteringCover();
+	TestIsLeavingCover();
+	TestTickHold();
+	TestMoveBlockedAtEdge();
+	TestIsFacingRight();
+	TestProbeEdges();
+	TestEdgeState();
+	TestIsCoverStandable();
+	TestDash();
+
+	if (Failures > 0)
+	{
+		std::printf("%d checks failed\n", Failures);
+		return 1;
+	}
+	std::printf("All checks passed\n");
+	return 0;
+}
@@ -7,22 +7,9 @@
 // Sets default values
 ABlasterPistol::ABlasterPistol()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
-
+	// Blasters fire bolts, simulated by the projectile manager rather than as actors
+	FiresBolts = true;
+	BoltSpeed = 4000.0f;
+	BoltLifetime = 1.5f;
+	FireInterval = 0.3f;
 }
-
-// Called when the game starts or when spawned
-void ABlasterPistol::BeginPlay()
-{
-	Super::BeginPlay();
-	
-}
-
-// Called every frame
-void ABlasterPistol::Tick( float DeltaTime )
-{
-	Super::Tick( DeltaTime );
-
-}
-
@@ -2,24 +2,16 @@
 
 #pragma once
 
-#include "GameFramework/Actor.h"
+#include "Gun.h"
 #include "BlasterPistol.generated.h"
 
 UCLASS()
-class SCAVENGER_API ABlasterPistol : public AActor
+class SCAVENGER_API ABlasterPistol : public AGun
 {
 	GENERATED_BODY()
 	
 public:	
 	// Sets default values for this actor's properties
 	ABlasterPistol();
-
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	
-	// Called every frame
-	virtual void Tick( float DeltaSeconds ) override;
-
-	
 	
 };
@@ -2,27 +2,48 @@
 
 #include "Scavenger.h"
 #include "Gun.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/SCS_Node.h"
 
 
 // Sets default values
 AGun::AGun()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Only the class defaults are ever used, nothing to do per frame
+	PrimaryActorTick.bCanEverTick = false;
 
 }
 
-// Called when the game starts or when spawned
-void AGun::BeginPlay()
+UMeshComponent* AGun::FindMeshTemplate(UClass* GunClass)
 {
-	Super::BeginPlay();
-	
+	if (!GunClass) return nullptr;
+
+	// Components a Blueprint adds live in its construction script rather than on the defaults
+	for (UClass* Class = GunClass; Class; Class = Class->GetSuperClass())
+	{
+		UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(Class);
+		if (!BlueprintClass || !BlueprintClass->SimpleConstructionScript) continue;
+
+		for (USCS_Node* Node : BlueprintClass->SimpleConstructionScript->GetAllNodes())
+		{
+			UMeshComponent* Template = Node ? Cast<UMeshComponent>(Node->ComponentTemplate) : nullptr;
+			if (Template) return Template;
+		}
+	}
+
+	// Native weapons with a mesh root
+	return Cast<UMeshComponent>(GunClass->GetDefaultObject<AGun>()->GetRootComponent());
 }
 
-// Called every frame
-void AGun::Tick( float DeltaTime )
+void AGun::BuildPelletPattern(const FVector& Direction, int32 Seed, TArray<FVector>& OutDirections) const
 {
-	Super::Tick( DeltaTime );
-
+	const float ConeHalfAngle = FMath::DegreesToRadians(SpreadAngle);
+	FRandomStream Stream(Seed);
+
+	OutDirections.Reset(PelletCount);
+	for (int32 i = 0; i < FMath::Max(PelletCount, 1); i++)
+	{
+		OutDirections.Add(ConeHalfAngle > 0.0f ? Stream.VRandCone(Direction, ConeHalfAngle) : Direction);
+	}
 }
-
@@ -5,6 +5,11 @@
 #include "GameFramework/Actor.h"
 #include "Gun.generated.h"
 
+/**
+ * Weapon definition. Never spawned: a character's UScavengerWeaponComponent reads the stats off the
+ * class defaults and instances the class's mesh component onto the character's hand, so an equipped
+ * weapon costs no actor, channel or tick of its own. Blueprint subclasses supply the mesh.
+ */
 UCLASS()
 class SCAVENGER_API AGun : public AActor
 {
@@ -14,12 +19,44 @@ public:
 	// Sets default values for this actor's properties
 	AGun();
 
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	
-	// Called every frame
-	virtual void Tick( float DeltaSeconds ) override;
+	// The mesh component GunClass is drawn with, to instance onto whoever holds it
+	static UMeshComponent* FindMeshTemplate(UClass* GunClass);
 
-	
-	
+	// Seconds between shots
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float FireInterval = 0.25f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float Damage = 20.0f;
+
+	// How far an instant-hit shot reaches
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float Range = 5000.0f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FName MuzzleSocket = TEXT("Muzzle");
+
+	// Rays per instant-hit shot, more than one makes this a spread weapon
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	int32 PelletCount = 1;
+
+	// Half-angle of the spread cone in degrees
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float SpreadAngle = 0.0f;
+
+	// Fire simulated bolts through the projectile manager instead of instant-hit traces
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	bool FiresBolts = false;
+
+	// Bolt speed in cm/s
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float BoltSpeed = 5000.0f;
+
+	// Seconds before an unimpeded bolt expires
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float BoltLifetime = 2.0f;
+
+	// Directions of every pellet in a shot aimed along Direction. The same Seed always gives the same
+	// pattern, so a shot is reproduced anywhere from its aim and seed alone.
+	virtual void BuildPelletPattern(const FVector& Direction, int32 Seed, TArray<FVector>& OutDirections) const;
 };
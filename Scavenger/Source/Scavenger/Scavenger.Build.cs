@@ -7,5 +7,13 @@ public class Scavenger : ModuleRules
 	public Scavenger(TargetInfo Target)
 	{
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "MoviePlayer", "Slate", "SlateCore", "AssetRegistry", "Json", "Sockets" });
+
+		// The asset audit measures textures as cooked for its target platform
+		if (UEBuildConfiguration.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.Add("TargetPlatform");
+		}
 	}
 }
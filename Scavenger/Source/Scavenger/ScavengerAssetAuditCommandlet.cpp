@@ -0,0 +1,384 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerAssetAuditCommandlet.h"
+#include "GameMapsSettings.h"
+#include "AssetRegistryModule.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Sound/SoundWave.h"
+#include "DeviceProfiles/DeviceProfileManager.h"
+#include "DeviceProfiles/DeviceProfile.h"
+#include "Json.h"
+#if WITH_EDITOR
+#include "Interfaces/ITargetPlatform.h"
+#include "Interfaces/ITargetPlatformManagerModule.h"
+#else
+class ITargetPlatform;
+#endif
+
+namespace ScavengerAudit
+{
+	enum class ECategory : uint8
+	{
+		Texture,
+		SkeletalMesh,
+		Animation,
+		Sound,
+		StaticMesh,
+		Other,
+		Count
+	};
+
+	static const TCHAR* CategoryNames[] =
+	{
+		TEXT("Texture"),
+		TEXT("SkeletalMesh"),
+		TEXT("Animation"),
+		TEXT("Sound"),
+		TEXT("StaticMesh"),
+		TEXT("Other"),
+	};
+
+	struct FMip
+	{
+		int32 SizeX;
+		int32 SizeY;
+		int64 Bytes;
+	};
+
+	struct FEntry
+	{
+		FString Path;
+		FString Class;
+		ECategory Category = ECategory::Other;
+		int64 ResidentBytes = 0;
+
+		// Textures only
+		FString Format;
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+		int32 FirstResidentMip = 0;
+		TArray<FMip> Mips;
+
+		TArray<FString> Flags;
+	};
+
+	static const double BytesPerMB = 1024.0 * 1024.0;
+}
+
+using namespace ScavengerAudit;
+
+static ECategory Categorize(const UObject* Asset)
+{
+	if (Asset->IsA<UTexture>()) return ECategory::Texture;
+	if (Asset->IsA<USkeletalMesh>()) return ECategory::SkeletalMesh;
+	if (Asset->IsA<UAnimSequenceBase>()) return ECategory::Animation;
+	if (Asset->IsA<USoundWave>()) return ECategory::Sound;
+	if (Asset->IsA<UStaticMesh>()) return ECategory::StaticMesh;
+	return ECategory::Other;
+}
+
+static void MeasureTexture(UTexture2D* Texture, const ITargetPlatform* TargetPlatform, const UTextureLODSettings& LODSettings, FEntry& Entry)
+{
+	// The data cooked for the target platform, in its formats, not what the editor built for itself.
+	// Dropping every other platform's cooked data first leaves the target's as the only entry.
+	FTexturePlatformData* PlatformData = nullptr;
+#if WITH_EDITOR
+	Texture->ClearAllCachedCookedPlatformData();
+	Texture->BeginCacheForCookedPlatformData(TargetPlatform);
+	while (!Texture->IsCachedCookedPlatformDataLoaded(TargetPlatform)) FPlatformProcess::Sleep(0.001f);
+
+	TMap<FString, FTexturePlatformData*>* CookedData = Texture->GetCookedPlatformData();
+	if (CookedData)
+	{
+		for (const auto& Cooked : *CookedData)
+		{
+			PlatformData = Cooked.Value;
+			break;
+		}
+	}
+#else
+	// Without the editor there is only the running platform's data
+	PlatformData = Texture->PlatformData;
+#endif
+
+	if (!PlatformData || PlatformData->Mips.Num() == 0)
+	{
+		Entry.ResidentBytes = Texture->GetResourceSize(EResourceSizeMode::Exclusive);
+		return;
+	}
+
+	Entry.Format = GPixelFormats[PlatformData->PixelFormat].Name;
+	Entry.SizeX = PlatformData->SizeX;
+	Entry.SizeY = PlatformData->SizeY;
+
+	// Mips skipped by the texture's LOD group and own bias, as the platform's device profile sets them, never become resident
+	Entry.FirstResidentMip = FMath::Clamp(LODSettings.CalculateLODBias(Texture), 0, PlatformData->Mips.Num() - 1);
+
+	for (int32 i = 0; i < PlatformData->Mips.Num(); i++)
+	{
+		const FTexture2DMipMap& Mip = PlatformData->Mips[i];
+
+		FMip Measured;
+		Measured.SizeX = Mip.SizeX;
+		Measured.SizeY = Mip.SizeY;
+		Measured.Bytes = Mip.BulkData.GetBulkDataSize();
+		Entry.Mips.Add(Measured);
+
+		if (i >= Entry.FirstResidentMip) Entry.ResidentBytes += Measured.Bytes;
+	}
+
+#if WITH_EDITOR
+	Texture->ClearCachedCookedPlatformData(TargetPlatform);
+#endif
+}
+
+UScavengerAssetAuditCommandlet::UScavengerAssetAuditCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UScavengerAssetAuditCommandlet::Main(const FString& Params)
+{
+	FString MapName = GetDefault<UGameMapsSettings>()->GetGameDefaultMap();
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	// The setting is an object path, the package checks and budget entries go by package name
+	MapName = FPackageName::ObjectPathToPackageName(MapName);
+
+#if WITH_EDITOR
+	ITargetPlatformManagerModule* PlatformManager = GetTargetPlatformManager();
+	FString Platform = PlatformManager->GetRunningTargetPlatform()->PlatformName();
+	FParse::Value(*Params, TEXT("Platform="), Platform);
+
+	const ITargetPlatform* TargetPlatform = PlatformManager->FindTargetPlatform(Platform);
+	if (!TargetPlatform)
+	{
+		FString Available;
+		for (const ITargetPlatform* Candidate : PlatformManager->GetTargetPlatforms()) Available += TEXT(" ") + Candidate->PlatformName();
+		UE_LOG(LogScavenger, Error, TEXT("Unknown platform %s, this editor can cook for:%s"), *Platform, *Available);
+		return 2;
+	}
+
+	// Texture LOD groups come from the platform's device profile, the host's if it has none of its own
+	UDeviceProfile* DeviceProfile = UDeviceProfileManager::Get().FindProfile(TargetPlatform->IniPlatformName());
+	if (!DeviceProfile) DeviceProfile = UDeviceProfileManager::Get().GetActiveProfile();
+	const UTextureLODSettings& LODSettings = *DeviceProfile;
+#else
+	const FString HostPlatform = ANSI_TO_TCHAR(FPlatformProperties::PlatformName());
+	FString Platform = HostPlatform;
+	FParse::Value(*Params, TEXT("Platform="), Platform);
+	if (Platform != HostPlatform)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Only the editor can measure %s's cooked data, this build has %s's only"), *Platform, *HostPlatform);
+		return 2;
+	}
+
+	const ITargetPlatform* TargetPlatform = nullptr;
+	const UTextureLODSettings& LODSettings = *UDeviceProfileManager::Get().GetActiveProfile();
+#endif
+
+	FString OutputPath = FPaths::Combine(*FPaths::GameSavedDir(), TEXT("Audit"),
+		*FString::Printf(TEXT("%s_%s.json"), *FPackageName::GetShortName(MapName), *Platform));
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	if (!FPackageName::DoesPackageExist(MapName))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Map %s not found"), *MapName);
+		return 2;
+	}
+
+	// Every content package the map reaches, directly or not. Script packages are code and hold no assets.
+	TArray<FName> Packages;
+	TSet<FName> Visited;
+	Packages.Add(FName(*MapName));
+	Visited.Add(Packages[0]);
+	for (int32 i = 0; i < Packages.Num(); i++)
+	{
+		TArray<FName> Dependencies;
+		AssetRegistry.GetDependencies(Packages[i], Dependencies);
+		for (const FName& Dependency : Dependencies)
+		{
+			if (Dependency.ToString().StartsWith(TEXT("/Script/")) || Visited.Contains(Dependency)) continue;
+			Visited.Add(Dependency);
+			Packages.Add(Dependency);
+		}
+	}
+
+	TArray<FEntry> Entries;
+	int64 CategoryBytes[(int32)ECategory::Count] = {};
+
+	for (int32 PackageIndex = 0; PackageIndex < Packages.Num(); PackageIndex++)
+	{
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(Packages[PackageIndex], Assets);
+
+		for (const FAssetData& AssetData : Assets)
+		{
+			UObject* Asset = AssetData.GetAsset();
+			if (!Asset || Asset->IsA<UWorld>() || Asset->IsA<UBlueprint>()) continue;
+
+			FEntry Entry;
+			Entry.Path = AssetData.ObjectPath.ToString();
+			Entry.Class = Asset->GetClass()->GetName();
+			Entry.Category = Categorize(Asset);
+
+			UTexture2D* Texture = Cast<UTexture2D>(Asset);
+			if (Texture) MeasureTexture(Texture, TargetPlatform, LODSettings, Entry);
+			else Entry.ResidentBytes = Asset->GetResourceSize(EResourceSizeMode::Exclusive);
+
+			if (Entry.SizeX > OversizedTextureDimension || Entry.SizeY > OversizedTextureDimension) Entry.Flags.Add(TEXT("OversizedTexture"));
+			if (Entry.ResidentBytes > OversizedAssetMB * BytesPerMB) Entry.Flags.Add(TEXT("Oversized"));
+
+			CategoryBytes[(int32)Entry.Category] += Entry.ResidentBytes;
+			Entries.Add(Entry);
+		}
+
+		// Keep memory flat while walking a large graph
+		if (PackageIndex % 64 == 63) CollectGarbage(RF_NoFlags);
+	}
+
+	// Same class, same name and same size in two places is almost always the same asset imported twice
+	TMap<FString, TArray<int32>> DuplicateGroups;
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		const FEntry& Entry = Entries[i];
+		const FString Key = FString::Printf(TEXT("%s|%s|%lld"), *Entry.Class, *FPackageName::ObjectPathToObjectName(Entry.Path), Entry.ResidentBytes);
+		DuplicateGroups.FindOrAdd(Key).Add(i);
+	}
+	int64 DuplicateBytes = 0;
+	for (const auto& Group : DuplicateGroups)
+	{
+		if (Group.Value.Num() < 2) continue;
+		for (int32 Index : Group.Value) Entries[Index].Flags.Add(TEXT("Duplicate"));
+		DuplicateBytes += Entries[Group.Value[0]].ResidentBytes * (Group.Value.Num() - 1);
+	}
+
+	Entries.Sort([](const FEntry& A, const FEntry& B) { return A.ResidentBytes > B.ResidentBytes; });
+
+	int64 TotalBytes = 0;
+	for (int64 Bytes : CategoryBytes) TotalBytes += Bytes;
+
+	// A platform's own entry wins over one that applies to every platform
+	const FScavengerMemoryBudget* Budget = nullptr;
+	for (const FScavengerMemoryBudget& Candidate : Budgets)
+	{
+		if (Candidate.Map != MapName) continue;
+		if (Candidate.Platform == Platform)
+		{
+			Budget = &Candidate;
+			break;
+		}
+		if (Candidate.Platform.IsEmpty() && !Budget) Budget = &Candidate;
+	}
+
+	struct FBudgetCheck
+	{
+		const TCHAR* Name;
+		int64 Bytes;
+		float LimitMB;
+	};
+	TArray<FBudgetCheck> Checks;
+	if (Budget)
+	{
+		Checks.Add({ TEXT("Texture"), CategoryBytes[(int32)ECategory::Texture], Budget->TextureMB });
+		Checks.Add({ TEXT("SkeletalMesh"), CategoryBytes[(int32)ECategory::SkeletalMesh], Budget->SkeletalMeshMB });
+		Checks.Add({ TEXT("Animation"), CategoryBytes[(int32)ECategory::Animation], Budget->AnimationMB });
+		Checks.Add({ TEXT("Sound"), CategoryBytes[(int32)ECategory::Sound], Budget->SoundMB });
+		Checks.Add({ TEXT("Total"), TotalBytes, Budget->TotalMB });
+	}
+	else
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("No memory budget configured for %s on %s"), *MapName, *Platform);
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("Map"), MapName);
+	Writer->WriteValue(TEXT("Platform"), Platform);
+	Writer->WriteValue(TEXT("Packages"), Packages.Num());
+	Writer->WriteValue(TEXT("TotalBytes"), (double)TotalBytes);
+	Writer->WriteValue(TEXT("DuplicateBytes"), (double)DuplicateBytes);
+
+	Writer->WriteObjectStart(TEXT("Categories"));
+	for (int32 i = 0; i < (int32)ECategory::Count; i++) Writer->WriteValue(CategoryNames[i], (double)CategoryBytes[i]);
+	Writer->WriteObjectEnd();
+
+	int32 OverBudget = 0;
+	Writer->WriteArrayStart(TEXT("Budgets"));
+	for (const FBudgetCheck& Check : Checks)
+	{
+		if (Check.LimitMB <= 0.0f) continue;
+		const bool Over = Check.Bytes > Check.LimitMB * BytesPerMB;
+		if (Over)
+		{
+			UE_LOG(LogScavenger, Error, TEXT("%s over budget: %.1f MB of %.1f MB"), Check.Name, Check.Bytes / BytesPerMB, Check.LimitMB);
+			OverBudget++;
+		}
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Category"), Check.Name);
+		Writer->WriteValue(TEXT("Bytes"), (double)Check.Bytes);
+		Writer->WriteValue(TEXT("LimitBytes"), Check.LimitMB * BytesPerMB);
+		Writer->WriteValue(TEXT("Over"), Over);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteArrayStart(TEXT("Assets"));
+	for (const FEntry& Entry : Entries)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Path"), Entry.Path);
+		Writer->WriteValue(TEXT("Class"), Entry.Class);
+		Writer->WriteValue(TEXT("Category"), CategoryNames[(int32)Entry.Category]);
+		Writer->WriteValue(TEXT("ResidentBytes"), (double)Entry.ResidentBytes);
+
+		if (Entry.Mips.Num() > 0)
+		{
+			Writer->WriteValue(TEXT("Format"), Entry.Format);
+			Writer->WriteValue(TEXT("SizeX"), Entry.SizeX);
+			Writer->WriteValue(TEXT("SizeY"), Entry.SizeY);
+			Writer->WriteValue(TEXT("FirstResidentMip"), Entry.FirstResidentMip);
+			Writer->WriteArrayStart(TEXT("Mips"));
+			for (const FMip& Mip : Entry.Mips)
+			{
+				Writer->WriteObjectStart();
+				Writer->WriteValue(TEXT("SizeX"), Mip.SizeX);
+				Writer->WriteValue(TEXT("SizeY"), Mip.SizeY);
+				Writer->WriteValue(TEXT("Bytes"), (double)Mip.Bytes);
+				Writer->WriteObjectEnd();
+			}
+			Writer->WriteArrayEnd();
+		}
+
+		if (Entry.Flags.Num() > 0)
+		{
+			Writer->WriteArrayStart(TEXT("Flags"));
+			for (const FString& Flag : Entry.Flags) Writer->WriteValue(Flag);
+			Writer->WriteArrayEnd();
+		}
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Could not write %s"), *OutputPath);
+		return 2;
+	}
+
+	UE_LOG(LogScavenger, Display, TEXT("%s on %s: %d assets in %d packages, %.1f MB resident, %.1f MB duplicated. Report in %s"),
+		*MapName, *Platform, Entries.Num(), Packages.Num(), TotalBytes / BytesPerMB, DuplicateBytes / BytesPerMB, *OutputPath);
+
+	return OverBudget > 0 ? 1 : 0;
+}
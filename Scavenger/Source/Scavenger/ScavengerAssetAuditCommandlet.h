@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ScavengerAssetAuditCommandlet.generated.h"
+
+// Resident memory allowed for one map on one platform, in MB. Zero leaves a category unchecked.
+USTRUCT()
+struct FScavengerMemoryBudget
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Long package name of the map
+	UPROPERTY(Config)
+	FString Map;
+
+	// Platform name as passed to -Platform, empty applies to any platform without its own entry
+	UPROPERTY(Config)
+	FString Platform;
+
+	UPROPERTY(Config)
+	float TextureMB = 0.0f;
+
+	UPROPERTY(Config)
+	float SkeletalMeshMB = 0.0f;
+
+	UPROPERTY(Config)
+	float AnimationMB = 0.0f;
+
+	UPROPERTY(Config)
+	float SoundMB = 0.0f;
+
+	UPROPERTY(Config)
+	float TotalMB = 0.0f;
+};
+
+/**
+ * Walks a map's full package dependency graph and reports the resident size of every asset it pulls
+ * in: textures per mip with their format, skeletal meshes, animations, sounds and everything else.
+ * Likely duplicates and oversized assets are flagged and category totals are checked against the
+ * configured budget for the map and platform. Textures are measured as cooked for -Platform, which
+ * must be one this editor can cook for, with the mips that platform's LOD settings drop left out.
+ * The report is written as JSON.
+ *
+ * UE4Editor-Cmd Scavenger -run=ScavengerAssetAudit [-Map=/Game/Default_Test] [-Platform=WindowsNoEditor]
+ *     [-Output=Saved/Audit/Default_Test_WindowsNoEditor.json]
+ */
+UCLASS(Config = Game)
+class UScavengerAssetAuditCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UScavengerAssetAuditCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	UPROPERTY(Config)
+	TArray<FScavengerMemoryBudget> Budgets;
+
+	// Textures with either side larger than this are flagged
+	UPROPERTY(Config)
+	int32 OversizedTextureDimension = 2048;
+
+	// Any single asset resident at more than this is flagged
+	UPROPERTY(Config)
+	float OversizedAssetMB = 8.0f;
+};
@@ -2,8 +2,71 @@
 
 #include "Scavenger.h"
 #include "ScavengerCharacter.h"
+#include "ScavengerGameInstance.h"
+#include "ScavengerGameState.h"
+#include "ScavengerHUD.h"
+#include "ScavengerKillCam.h"
+#include "ScavengerStats.h"
+#include "ScavengerTrace.h"
+#include "ScavengerWeaponComponent.h"
+#include "ScavengerCoverCore.h"
+#include "ScavengerCorpseManager.h"
+#include "ScavengerInputLatency.h"
+#include "ScavengerRpcLimiter.h"
+#include "ScavengerSkin.h"
+#include "ScavengerSkinManager.h"
 
 #include "UnrealNetwork.h"
+#include "Components/DecalComponent.h"
+
+static int32 GAimAssist = 1;
+static FAutoConsoleVariableRef CVarAimAssist(
+	TEXT("scav.AimAssist"),
+	GAimAssist,
+	TEXT("Slowdown and friction on gamepad look input near other characters. 0 turns it off."),
+	ECVF_Default);
+
+// Matches the inline size of AimSnapshots
+static const int32 MaxAimSnapshots = 8;
+
+// Height above the actor location the standing check traces at
+static const float CoverHeadHeight = 20.0f;
+
+static ScavengerCover::FVec3 ToCoverVec(const FVector& V)
+{
+	return ScavengerCover::FVec3{ V.X, V.Y, V.Z };
+}
+
+// Routes the cover core's traces through the character's world
+struct FCharacterCoverQuery : public ScavengerCover::ICoverWorldQuery
+{
+	explicit FCharacterCoverQuery(const AScavengerCharacter* InCharacter)
+		: Character(InCharacter)
+	{
+	}
+
+	virtual ScavengerCover::ECoverHit TraceStatic(const ScavengerCover::FVec3& Start, const ScavengerCover::FVec3& End) const override
+	{
+		//Set up Query Parameters
+		FCollisionQueryParams TraceParameters(FName(TEXT("")), false, Character->GetOwner());
+		FHitResult Hit;
+
+		SCAV_COUNT_TRACE(1);
+		Character->GetWorld()->LineTraceSingleByObjectType(
+			Hit,
+			FVector(Start.X, Start.Y, Start.Z),
+			FVector(End.X, End.Y, End.Z),
+			FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
+			TraceParameters
+		);
+
+		if (!Hit.GetComponent()) return ScavengerCover::ECoverHit::None;
+		if (Hit.GetComponent()->ComponentHasTag("Cover")) return ScavengerCover::ECoverHit::Cover;
+		return ScavengerCover::ECoverHit::Blocking;
+	}
+
+	const AScavengerCharacter* Character;
+};
 
 //////////////////////////////////////////////////////////////////////////
 // AScavengerCharacter
@@ -44,6 +107,8 @@ AScavengerCharacter::AScavengerCharacter()
 	FollowCamera->AttachTo(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	Weapon = CreateDefaultSubobject<UScavengerWeaponComponent>(TEXT("Weapon"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 }
@@ -57,17 +122,22 @@ void AScavengerCharacter::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >
 	//DOREPLIFETIME(AScavengerCharacter, MyMove);
 	DOREPLIFETIME(AScavengerCharacter, InCoverCPP);
 	DOREPLIFETIME(AScavengerCharacter, CrouchedCPP);
-	DOREPLIFETIME(AScavengerCharacter, CoverFacingRightCPP);
+	// Always notify: a proxy shows older values than it has received, so a new value can match what's on screen
+	DOREPLIFETIME_CONDITION_NOTIFY(AScavengerCharacter, CoverFacingRightCPP, COND_None, REPNOTIFY_Always);
 	DOREPLIFETIME(AScavengerCharacter, CurrentCoverDirection);
 	DOREPLIFETIME(AScavengerCharacter, Dashing);
 	DOREPLIFETIME(AScavengerCharacter, Running);
 	DOREPLIFETIME(AScavengerCharacter, DashDirection);
 	DOREPLIFETIME(AScavengerCharacter, IsDashingCPP);
-	DOREPLIFETIME(AScavengerCharacter, IsPoppedOutCPP);
+	DOREPLIFETIME_CONDITION_NOTIFY(AScavengerCharacter, IsPoppedOutCPP, COND_None, REPNOTIFY_Always);
 	DOREPLIFETIME(AScavengerCharacter, IsAimingCPP);
 	DOREPLIFETIME(AScavengerCharacter, IsDeadCPP);
-	DOREPLIFETIME(AScavengerCharacter, AimPitchCPP);
-	DOREPLIFETIME(AScavengerCharacter, AimYawCPP);
+	DOREPLIFETIME(AScavengerCharacter, HealthCPP);
+	DOREPLIFETIME_CONDITION_NOTIFY(AScavengerCharacter, AimPitchCPP, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(AScavengerCharacter, AimYawCPP, COND_None, REPNOTIFY_Always);
+	// Same audience as ReplicatedMovement, which it stands in for
+	DOREPLIFETIME_CONDITION(AScavengerCharacter, CoverMovement, COND_SimulatedOnly);
+	DOREPLIFETIME(AScavengerCharacter, SkinIndex);
 	
 }
 
@@ -85,15 +155,18 @@ void AScavengerCharacter::SetupPlayerInputComponent(class UInputComponent* Input
 	InputComponent->BindAxis("MoveRight", this, &AScavengerCharacter::MoveRight);
 
 	//Run Button
-	InputComponent->BindAction("Run", IE_Pressed, this, &AScavengerCharacter::StartRunning);
-	InputComponent->BindAction("Run", IE_Released, this, &AScavengerCharacter::StartWalking);
+	InputComponent->BindAction("Run", IE_Pressed, this, &AScavengerCharacter::RunPressed);
+	InputComponent->BindAction("Run", IE_Released, this, &AScavengerCharacter::RunReleased);
 
 	//Aim Button
-	InputComponent->BindAction("Aim", IE_Pressed, this, &AScavengerCharacter::LocalStartAiming);
-	InputComponent->BindAction("Aim", IE_Released, this, &AScavengerCharacter::LocalStopAiming);
+	InputComponent->BindAction("Aim", IE_Pressed, this, &AScavengerCharacter::AimPressed);
+	InputComponent->BindAction("Aim", IE_Released, this, &AScavengerCharacter::AimReleased);
 
 	InputComponent->BindAction("TakeCover", IE_Pressed, this, &AScavengerCharacter::Die);
 
+	//Fire Button
+	InputComponent->BindAction("Fire", IE_Pressed, this, &AScavengerCharacter::LocalFire);
+
 	//Cover Button
 	//InputComponent->BindAction("TakeCover", IE_Pressed, this, &AScavengerCharacter::CoverButton);
 
@@ -133,8 +206,37 @@ void AScavengerCharacter::SetupPlayerInputComponent(class UInputComponent* Input
 	}
 }
 
+void AScavengerCharacter::AimPressed()
+{
+	if (!IsAimingCPP) FScavengerInputLatency::Begin(EScavengerInputAction::Aim);
+	LocalStartAiming();
+}
+
+void AScavengerCharacter::AimReleased()
+{
+	if (IsAimingCPP || FScavengerInputLatency::IsPending(EScavengerInputAction::Aim)) FScavengerInputLatency::Begin(EScavengerInputAction::StopAim);
+	LocalStopAiming();
+}
+
+void AScavengerCharacter::RunPressed()
+{
+	if (!Running) FScavengerInputLatency::Begin(EScavengerInputAction::Run);
+	StartRunning();
+}
+
+void AScavengerCharacter::RunReleased()
+{
+	if (Running || FScavengerInputLatency::IsPending(EScavengerInputAction::Run)) FScavengerInputLatency::Begin(EScavengerInputAction::StopRun);
+	StartWalking();
+}
+
 void AScavengerCharacter::StartRunning_Implementation()
 {
+	SCAV_COUNT_RPC(StartRunning, 0);
+	if (!BeginServerRpc(EScavengerRpc::StartRunning)) return;
+	// The client paid for this call, not for the ones it makes on its behalf
+	AScavengerRpcLimiter::FExemptScope Exempt;
+
 	RunKeyPressed = true;
 
 	if (Dashing)
@@ -149,7 +251,7 @@ void AScavengerCharacter::StartRunning_Implementation()
 	{
 		//UE_LOG(LogTemp, Warning, TEXT("In Cover, %d, %d"), DashCooldownTimer, DashCooldown);
 
-		if (DashCooldownTimer >= DashCooldown)
+		if (ScavengerCover::IsDashReady(DashCooldownTimer, DashCooldown))
 		{
 			//UE_LOG(LogTemp, Warning, TEXT("Dash!"));
 			ExitCover();
@@ -169,6 +271,9 @@ void AScavengerCharacter::StartRunning_Implementation()
 
 void AScavengerCharacter::StartWalking_Implementation()
 {
+	SCAV_COUNT_RPC(StartWalking, 0);
+	if (!BeginServerRpc(EScavengerRpc::StartWalking)) return;
+
 	RunKeyPressed = false;
 	if (Dashing) return;
 	Running = false;
@@ -180,6 +285,9 @@ void AScavengerCharacter::StartWalking_Implementation()
 
 void AScavengerCharacter::StartDash_Implementation()
 {
+	SCAV_COUNT_RPC(StartDash, 0);
+	if (!BeginServerRpc(EScavengerRpc::StartDash)) return;
+
 	DashTimer = 0;
 	Dashing = true;
 	//FVector MoveVector = GetMovementComponent()->GetLastInputVector();
@@ -195,15 +303,17 @@ void AScavengerCharacter::StartDash_Implementation()
 	ClientUpdateWalkSpeed(DashSpeed);
 	DashDirection = MoveVector;
 	IsDashingCPP = true;
+
+	SCAV_TRACE(DashStart, this, DashDirection.X, DashDirection.Y, DashDirection.Z);
 }
 
 void AScavengerCharacter::ExecuteDash()
 {
 	if (Role == ROLE_Authority)
 	{
-		DashTimer++;
-		if (DashTimer >= DashDuration)
+		if (ScavengerCover::TickDash(DashTimer, DashDuration))
 		{
+			AScavengerRpcLimiter::FExemptScope Exempt;
 			StopDash();
 		}
 	}
@@ -213,6 +323,10 @@ void AScavengerCharacter::ExecuteDash()
 
 void AScavengerCharacter::StopDash_Implementation()
 {
+	SCAV_COUNT_RPC(StopDash, 0);
+	if (!BeginServerRpc(EScavengerRpc::StopDash)) return;
+	SCAV_TRACE(DashStop, this, DashTimer);
+
 	Dashing = false;
 	DashCooldownTimer = 0;
 	DashTimer = 0;
@@ -221,6 +335,7 @@ void AScavengerCharacter::StopDash_Implementation()
 	IsDashingCPP = false;
 	if (!InCoverCPP)
 	{
+		AScavengerRpcLimiter::FExemptScope Exempt;
 		if (RunKeyPressed) StartRunning();
 		else StartWalking();
 	}
@@ -245,18 +360,34 @@ void AScavengerCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector Lo
 
 void AScavengerCharacter::TurnAtRate(float Rate)
 {
+	LookRateInput = FMath::Max(LookRateInput, FMath::Abs(Rate));
+
 	// calculate delta for this frame from the rate information
-	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
+	AddControllerYawInput(Rate * GetAimAssistRateScale() * BaseTurnRate * GetWorld()->GetDeltaSeconds());
 }
 
 void AScavengerCharacter::LookUpAtRate(float Rate)
 {
+	LookRateInput = FMath::Max(LookRateInput, FMath::Abs(Rate));
+
 	// calculate delta for this frame from the rate information
-	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
+	AddControllerPitchInput(Rate * GetAimAssistRateScale() * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
+}
+
+float AScavengerCharacter::GetAimAssistRateScale() const
+{
+	// Mouse look goes straight to the controller and never gets here
+	return FMath::Lerp(1.0f, AimAssistSlowdown, AimAssistStrength);
 }
 
 void AScavengerCharacter::MoveForward(float Value)
 {
+	if (Value != 0.0f)
+	{
+		if (!HadMoveInput && GetVelocity().IsZero()) FScavengerInputLatency::Begin(EScavengerInputAction::Move);
+		HasMoveInput = true;
+	}
+
 	if ((Controller != NULL) && (Value != 0.0f))
 	{
 		// find out which way is forward
@@ -271,6 +402,12 @@ void AScavengerCharacter::MoveForward(float Value)
 
 void AScavengerCharacter::MoveRight(float Value)
 {
+	if (Value != 0.0f)
+	{
+		if (!HadMoveInput && GetVelocity().IsZero()) FScavengerInputLatency::Begin(EScavengerInputAction::Move);
+		HasMoveInput = true;
+	}
+
 	if ( (Controller != NULL) && (Value != 0.0f) )
 	{
 		// find out which way is right
@@ -290,31 +427,20 @@ bool AScavengerCharacter::CheckIsMovementAllowed(FVector Direction, float Value)
 	if (IsPoppedOutCPP) return false;
 	if (InCoverCPP && MyMove)
 	{
+		const ScavengerCover::FVec3 LastInput = ToCoverVec(MyMove->GetLastInputVector());
+
 		// Check if we are trying to leave cover by pulling off
-		float AngleFound = AngleBetween(MyMove->GetLastInputVector(), -CurrentCoverDirection);
-		if (AngleFound <= MaxCoverAngle)
+		const bool Leaving = ScavengerCover::IsLeavingCover(LastInput, ToCoverVec(CurrentCoverDirection), CosMaxCoverAngle);
+		if (ScavengerCover::TickHold(Leaving, EnterCoverTimer, EnterCoverHoldTime))
 		{
-			EnterCoverTimer++;
-			if (EnterCoverTimer >= EnterCoverHoldTime)
-			{
-				EnterCoverTimer = 0;
-				ExitCover();
-			}
+			// Also runs on the server as it moves the character, where this isn't the client asking
+			AScavengerRpcLimiter::FExemptScope Exempt;
+			ExitCover();
 		}
 
-		if (EdgeAdjustedLeft)
-		{
-			if (AngleBetween(-GetActorRightVector(), MyMove->GetLastInputVector()) < 90.0)
-			{
-				return false;
-			}
-		}
-		else if (EdgeAdjustedRight)
+		if (ScavengerCover::IsMoveBlockedAtEdge(LastInput, ToCoverVec(GetActorRightVector()), CoverEdges.AdjustedLeft, CoverEdges.AdjustedRight))
 		{
-			if (AngleBetween(GetActorRightVector(), MyMove->GetLastInputVector()) < 90.0)
-			{
-				return false;
-			}
+			return false;
 		}
 	}
 
@@ -341,17 +467,14 @@ void AScavengerCharacter::OnHit(AActor* OtherActor, UPrimitiveComponent* OtherCo
 		//SurfaceNormal += GetActorLocation();
 		//DrawDebugLine(GetWorld(), Hit.ImpactPoint, Hit.ImpactPoint + SurfaceNormal*40.0f, FColor(255, 0, 0), false, 0.0f, 0, 10.0f);
 		//Check if approach angle is less than the maximum angle to enter cover, to prevent drivebys
-		float AngleFound = AngleBetween(MoveVector, SurfaceNormal * -1);
-		if (AngleFound < MaxCoverAngle && InCoverCPP == false)
+		const bool Entering = !InCoverCPP && ScavengerCover::IsEnteringCover(ToCoverVec(MoveVector), ToCoverVec(SurfaceNormal), CosMaxCoverAngle);
+		// Cover is taken by pushing into it, so its latency runs from the first push and includes the hold
+		if (Entering && IsLocallyControlled()) FScavengerInputLatency::Begin(EScavengerInputAction::TakeCover);
+		if (ScavengerCover::TickHold(Entering, EnterCoverTimer, EnterCoverHoldTime))
 		{
-			EnterCoverTimer++;
-			if (EnterCoverTimer >= EnterCoverHoldTime)
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("EnteringCoverOhGodHelp, %f"), AngleFound);
-				CurrentCoverDirection = SurfaceNormal * -1;
-				EnterCoverTimer = 0;
-				EnterCover(GetMovementComponent()->GetLastInputVector(), CurrentCoverDirection);
-			}
+			CurrentCoverDirection = SurfaceNormal * -1;
+			AScavengerRpcLimiter::FExemptScope Exempt;
+			EnterCover(GetMovementComponent()->GetLastInputVector(), CurrentCoverDirection);
 		}
 	}
 }
@@ -425,12 +548,14 @@ void AScavengerCharacter::UpdateAiming()
 
 		if (MyPC && GetFollowCamera())
 		{
-			// Got a PlayerController
-			//AHUD* MyHud = MyPC->GetHUD();
-			
+			// Native HUD deprojects the crosshair now, so this frame's trace uses this frame's camera
+			AScavengerHUD* MyHud = Cast<AScavengerHUD>(MyPC->GetHUD());
+			if (MyHud) MyHud->UpdateCrosshair(this);
+
 			FVector CrosshairLocation = CrosshairLocationCPP;
 			FVector CameraDirection = CrosshairRayCPP;
 
+			SCAV_COUNT_TRACE(1);
 			GetWorld()->LineTraceSingleByObjectType(
 				AimHit,
 				CrosshairLocation,
@@ -440,13 +565,16 @@ void AScavengerCharacter::UpdateAiming()
 			);
 
 			FVector DirectionToTarget;
+			AimTargetLocation = CrosshairLocation + (CrosshairRayCPP * AimDistance);
 
 			if (AimHit.GetActor())
 			{
 				DirectionToTarget = AimHit.ImpactPoint - GetCharacterMovement()->GetActorLocation();
+				AimTargetLocation = AimHit.ImpactPoint;
 			}
 			else DirectionToTarget = CameraDirection;
 
+			SCAV_COUNT_TRACE(1);
 			GetWorld()->LineTraceSingleByObjectType(
 				AimHit,
 				CrosshairLocation,
@@ -458,6 +586,7 @@ void AScavengerCharacter::UpdateAiming()
 			if (AimHit.GetActor())
 			{
 				DirectionToTarget = AimHit.ImpactPoint - GetCharacterMovement()->GetActorLocation();
+				AimTargetLocation = AimHit.ImpactPoint;
 			}
 			
 			//DrawDebugLine(GetWorld(), GetCharacterMovement()->GetActorLocation(), GetCharacterMovement()->GetActorLocation() + DirectionToTarget, FColor(0, 255, 0), false, 0.0f, 0, 10.0f);
@@ -469,8 +598,26 @@ void AScavengerCharacter::UpdateAiming()
 			}*/
 		}
 
-		ServerSetAimPitch(AimPitchCPP);
-		ServerSetAimYaw(AimYawCPP);
+		// Remote machines interpolate aim, so it only goes out every AimSendInterval and only when it moved.
+		// The setters are unreliable, so now and then it goes out anyway, or a lost last update would stick.
+		const float Now = GetWorld()->GetTimeSeconds();
+		if (Now >= NextAimSendTime)
+		{
+			NextAimSendTime = Now + AimSendInterval;
+			const bool Resend = ++AimResendTimer >= AimResendFrequency;
+			if (Resend) AimResendTimer = 0;
+
+			if (Resend || AimPitchCPP != LastSentAimPitch)
+			{
+				ServerSetAimPitch(AimPitchCPP);
+				LastSentAimPitch = AimPitchCPP;
+			}
+			if (Resend || AimYawCPP != LastSentAimYaw)
+			{
+				ServerSetAimYaw(AimYawCPP);
+				LastSentAimYaw = AimYawCPP;
+			}
+		}
 	}
 
 	if (Role < ROLE_Authority)
@@ -481,9 +628,251 @@ void AScavengerCharacter::UpdateAiming()
 	
 }
 
+void AScavengerCharacter::UpdateAimAssist()
+{
+	const float StickInput = LookRateInput;
+	LookRateInput = 0.0f;
+
+	const AScavengerCharacter* PreviousTarget = AimAssistTarget.Get();
+	AimAssistTarget = nullptr;
+	AimAssistStrength = 0.0f;
+
+	AScavengerGameState* GameState = AScavengerGameState::Get(this);
+	if (!GAimAssist || IsDeadCPP || !GameState || !GetFollowCamera()) return;
+
+	// Only characters near the crosshair ray, so the cost is the same with 4 players or 64
+	const FVector Start = CrosshairLocationCPP;
+	GameState->GetCharacterHash().QuerySegment(Start, Start + CrosshairRayCPP * AimAssistRange, AimAssistRadius, AimAssistMaxCandidates, this, AimAssistCandidates);
+
+	AScavengerCharacter* Target = nullptr;
+	float Strength = 0.0f;
+	for (AScavengerCharacter* Candidate : AimAssistCandidates)
+	{
+		const FVector ToCandidate = Candidate->GetActorLocation() - Start;
+		const float Along = FVector::DotProduct(ToCandidate, CrosshairRayCPP);
+		if (Along <= 0.0f || Along > AimAssistRange) continue;
+
+		const float CandidateStrength = 1.0f - (ToCandidate - CrosshairRayCPP * Along).Size() / AimAssistRadius;
+		if (CandidateStrength > Strength)
+		{
+			Target = Candidate;
+			Strength = CandidateStrength;
+		}
+	}
+	if (!Target) return;
+
+	// No pulling through walls, one trace for the winner only
+	FCollisionQueryParams TraceParameters(FName(TEXT("AimAssistTrace")), false, this);
+	TraceParameters.AddIgnoredActor(Target);
+	SCAV_COUNT_TRACE(1);
+	if (GetWorld()->LineTraceTestByObjectType(Start, Target->GetActorLocation(), FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic), TraceParameters)) return;
+
+	AimAssistTarget = Target;
+	AimAssistStrength = Strength;
+
+	// Friction: while the player is steering, follow part of the target's movement across the view
+	// so the slowdown doesn't make a moving target harder to track
+	const FRotator TargetRotation = (Target->GetActorLocation() - GetFollowCamera()->GetComponentLocation()).Rotation();
+	if (Target == PreviousTarget && StickInput > 0.0f && MyPC)
+	{
+		const FRotator Delta = (TargetRotation - AimAssistLastTargetRotation).GetNormalized();
+		const float Follow = AimAssistFriction * Strength;
+
+		// Controller input is scaled by the player controller, undo that so the follow is in degrees
+		if (MyPC->InputYawScale != 0.0f) AddControllerYawInput(Delta.Yaw * Follow / MyPC->InputYawScale);
+		if (MyPC->InputPitchScale != 0.0f) AddControllerPitchInput(Delta.Pitch * Follow / MyPC->InputPitchScale);
+	}
+	AimAssistLastTargetRotation = TargetRotation;
+}
+
 void AScavengerCharacter::Die_Implementation()
 {
+	SCAV_COUNT_RPC(Die, 0);
+	if (!BeginServerRpc(EScavengerRpc::Die)) return;
+
+	HandleDeath(nullptr);
+}
+
+void AScavengerCharacter::HandleDeath(AActor* Killer)
+{
+	if (IsDeadCPP) return;
 	IsDeadCPP = true;
+	SCAV_TRACE(Death, this);
+
+	// Nobody sees the body on a dedicated server, so stop posing it
+	if (GetNetMode() == NM_DedicatedServer) GetMesh()->SetComponentTickEnabled(false);
+
+	AScavengerGameState* GameState = AScavengerGameState::Get(this);
+	if (GameState) GameState->AddCombatEvent(EScavengerCombatEventType::Kill, Killer, this, GetActorLocation(), FVector::UpVector, 0.0f);
+}
+
+void AScavengerCharacter::ResetForRound(const FVector& Location, const FRotator& Rotation)
+{
+	if (Role != ROLE_Authority) return;
+
+	// Through the same paths play uses, so every replicated flag goes back the usual way, and
+	// whatever budget the owning client has left doesn't come into it
+	AScavengerRpcLimiter::FExemptScope Exempt;
+	ApplyCoalescedRpcs();
+
+	if (Dashing) StopDash();
+	if (InCoverCPP) ExitCover();
+	if (IsAimingCPP) StopAiming();
+	StartWalking();
+
+	IsDeadCPP = false;
+	HealthCPP = MaxHealth;
+	RestoreBody();
+
+	GetCharacterMovement()->StopMovementImmediately();
+	TeleportTo(Location, Rotation, false, false);
+	if (Controller) Controller->SetControlRotation(Rotation);
+
+	// The owning client's control rotation is its own, it has to be told
+	APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if (PlayerController) PlayerController->ClientSetRotation(Rotation);
+
+	Weapon->ResetForRound(WeaponBPClass);
+
+	ClientResetForRound();
+}
+
+void AScavengerCharacter::OnRep_IsDead()
+{
+	if (!IsDeadCPP) RestoreBody();
+}
+
+void AScavengerCharacter::RestoreBody()
+{
+	AScavengerCorpseManager* Corpses = AScavengerCorpseManager::Get(GetWorld());
+	if (Corpses) Corpses->RemoveCorpse(this);
+
+	const AScavengerCharacter* Defaults = GetClass()->GetDefaultObject<AScavengerCharacter>();
+	USkeletalMeshComponent* Body = GetMesh();
+
+	// A ragdoll leaves the mesh wherever it fell, off the capsule
+	Body->SetAllBodiesSimulatePhysics(false);
+	Body->bBlendPhysics = Defaults->GetMesh()->bBlendPhysics;
+	Body->AttachTo(GetCapsuleComponent(), NAME_None, EAttachLocation::KeepRelativeOffset);
+	Body->SetRelativeLocationAndRotation(Defaults->GetMesh()->RelativeLocation, Defaults->GetMesh()->RelativeRotation);
+	Body->SetCollisionProfileName(Defaults->GetMesh()->GetCollisionProfileName());
+
+	Body->bNoSkeletonUpdate = false;
+	Body->SetComponentTickEnabled(true);
+	Body->SetVisibility(true, true);
+
+	GetCapsuleComponent()->SetCollisionEnabled(Defaults->GetCapsuleComponent()->GetCollisionEnabled());
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+}
+
+float AScavengerCharacter::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	if (Role < ROLE_Authority || IsDeadCPP) return 0.0f;
+
+	float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	HealthCPP -= ActualDamage;
+
+	// Hit location and direction, if the damage came with them
+	FVector HitLocation = GetActorLocation();
+	FVector HitNormal = FVector::UpVector;
+	if (DamageEvent.IsOfType(FPointDamageEvent::ClassID))
+	{
+		const FPointDamageEvent& PointDamage = static_cast<const FPointDamageEvent&>(DamageEvent);
+		HitLocation = PointDamage.HitInfo.ImpactPoint;
+		HitNormal = -PointDamage.ShotDirection;
+	}
+
+	AActor* Attacker = EventInstigator ? EventInstigator->GetPawn() : DamageCauser;
+
+	AScavengerGameState* GameState = AScavengerGameState::Get(this);
+	if (GameState) GameState->AddCombatEvent(EScavengerCombatEventType::Hit, Attacker, this, HitLocation, HitNormal, ActualDamage);
+
+	if (HealthCPP <= 0.0f)
+	{
+		HealthCPP = 0.0f;
+		HandleDeath(Attacker);
+	}
+	return ActualDamage;
+}
+
+void AScavengerCharacter::LocalFire()
+{
+	if (IsDeadCPP || Dashing || !Weapon->GetWeapon()) return;
+	if (InCoverCPP && !IsPoppedOutCPP) return; // Can't shoot through our own cover
+
+	FVector Origin = Weapon->GetMuzzleLocation();
+	FVector Direction = (AimTargetLocation - Origin).GetSafeNormal();
+	if (Direction.IsZero()) Direction = GetControlRotation().Vector();
+
+	// Pellets aren't sent, the server rebuilds the spread from the shot number
+	ServerFire(Origin, Direction, Weapon->TakeShotId());
+}
+
+void AScavengerCharacter::ServerFire_Implementation(FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction, uint16 ShotId)
+{
+	SCAV_COUNT_RPC(Fire, 2 * sizeof(FVector) + sizeof(uint16));
+	if (!BeginServerRpc(EScavengerRpc::Fire)) return;
+
+	if (IsDeadCPP || Dashing) return;
+
+	// Neither the muzzle nor the aim may be far from where the server has them
+	FVector MuzzleLocation = Weapon->GetMuzzleLocation();
+	if (FVector::DistSquared(Origin, MuzzleLocation) > FMath::Square(MaxMuzzleError)) Origin = MuzzleLocation;
+
+	// Shots go from the muzzle to the crosshair, not along the view, so some difference is honest
+	const FVector ServerAim = GetControlRotation().Vector();
+	if ((Direction | ServerAim) < FMath::Cos(FMath::DegreesToRadians(MaxAimError)))
+	{
+		const FVector Axis = (ServerAim ^ Direction).GetSafeNormal();
+		Direction = Axis.IsZero() ? ServerAim : ServerAim.RotateAngleAxis(MaxAimError, Axis);
+	}
+
+	if (Weapon->Fire(Origin, Direction, ShotId)) SCAV_TRACE(Fire, this, Direction.X, Direction.Y, Direction.Z);
+}
+
+void AScavengerCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Blueprints are cooked with their camera, sound and effect components, a dedicated server drops them
+	// before play so it doesn't tick or keep them around for every character
+	if (GetNetMode() == NM_DedicatedServer) StripPresentationComponents();
+
+	// Picks up the angle from the blueprint or level instance
+	SetMaxCoverAngle(MaxCoverAngle);
+}
+
+void AScavengerCharacter::SetMaxCoverAngle(int Degrees)
+{
+	MaxCoverAngle = Degrees;
+	CosMaxCoverAngle = ScavengerCover::CosFromDegrees(MaxCoverAngle);
+}
+
+#if WITH_EDITOR
+void AScavengerCharacter::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(AScavengerCharacter, MaxCoverAngle)) SetMaxCoverAngle(MaxCoverAngle);
+}
+#endif
+
+void AScavengerCharacter::StripPresentationComponents()
+{
+	TInlineComponentArray<UActorComponent*> Components;
+	GetComponents(Components);
+
+	for (UActorComponent* Component : Components)
+	{
+		if (Component->IsA<UCameraComponent>() || Component->IsA<USpringArmComponent>() || Component->IsA<UAudioComponent>()
+			|| Component->IsA<UParticleSystemComponent>() || Component->IsA<UDecalComponent>())
+		{
+			Component->DestroyComponent();
+		}
+	}
+
+	CameraBoom = nullptr;
+	FollowCamera = nullptr;
 }
 
 void AScavengerCharacter::BeginPlay()
@@ -492,17 +881,22 @@ void AScavengerCharacter::BeginPlay()
 
 	//UE_LOG(LogTemp, Warning, TEXT("Derp"));
 
+	if (Role == ROLE_Authority) HealthCPP = MaxHealth;
+
 	UWorld* const World = GetWorld();
 
-	if (World) {
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.Instigator = this;
-		EquippedWeapon = World->SpawnActor<AGun>(WeaponBPClass, GetActorLocation(), GetActorRotation(), SpawnParams);
-	}
+	// Clients get the weapon with the rest of this character's replicated state
+	if (Role == ROLE_Authority) Weapon->Equip(WeaponBPClass);
+
+	// Up before anyone can die, it picks deaths up from the combat feed
+	AScavengerCorpseManager::Get(World);
 
-	FName fnWeaponSocket = TEXT("RHand_Socket");
+	// A skin replicated with the spawn was held until now
+	UpdateSkin();
 
-	EquippedWeapon->AttachRootComponentTo(GetMesh(),fnWeaponSocket, EAttachLocation::SnapToTarget, true);
+	// Every character is recorded for the local player's kill-cam, its ghost wearing the skin put on above
+	AScavengerKillCam* KillCam = AScavengerKillCam::Get(World);
+	if (KillCam) KillCam->Track(this);
 
 	MyPC = Cast<APlayerController>(Controller);
 
@@ -517,14 +911,117 @@ void AScavengerCharacter::BeginPlay()
 	}
 }
 
+void AScavengerCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Leaving relevancy destroys the character, which is what lets an unused skin unload. Only found,
+	// never spawned: a world tearing down may already have lost its manager and mustn't get a new one.
+	AScavengerSkinManager* Skins = WornSkinIndex != 0 ? AScavengerSkinManager::Find(GetWorld()) : nullptr;
+	if (Skins) Skins->Release(WornSkinIndex);
+	WornSkinIndex = 0;
+
+	AScavengerGameState* GameState = AScavengerGameState::Get(this);
+	if (GameState && InCharacterHash) GameState->GetCharacterHash().Remove(this);
+	InCharacterHash = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AScavengerCharacter::SetSkin(int32 NewSkinIndex)
+{
+	if (Role != ROLE_Authority) return;
+
+	SkinIndex = (uint8)FMath::Clamp(NewSkinIndex, 0, FMath::Min(AScavengerSkinManager::GetNumSkins(), 255));
+	UpdateSkin();
+}
+
+void AScavengerCharacter::OnRep_SkinIndex()
+{
+	UpdateSkin();
+}
+
+void AScavengerCharacter::UpdateSkin()
+{
+	if (!HasActorBegunPlay() || SkinIndex == WornSkinIndex) return;
+
+	AScavengerSkinManager* Skins = AScavengerSkinManager::Get(GetWorld());
+	if (!Skins) return;
+
+	if (WornSkinIndex) Skins->Release(WornSkinIndex);
+	WornSkinIndex = SkinIndex;
+
+	// Keeps showing the current mesh until the new skin has streamed in
+	if (WornSkinIndex) Skins->Acquire(this, WornSkinIndex);
+	else WearSkin(nullptr);
+}
+
+void AScavengerCharacter::WearSkin(UScavengerSkin* Skin)
+{
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	const ACharacter* Defaults = GetClass()->GetDefaultObject<ACharacter>();
+	USkeletalMesh* NewMesh = Skin ? Skin->Mesh.Get() : Defaults->GetMesh()->SkeletalMesh;
+	if (!MeshComponent || !NewMesh) return;
+
+	// The animation Blueprint is shared, so a skin on another skeleton can't be worn
+	USkeletalMesh* CurrentMesh = MeshComponent->SkeletalMesh;
+	if (CurrentMesh && NewMesh->Skeleton != CurrentMesh->Skeleton)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Skin mesh %s isn't on %s's skeleton, keeping %s"), *NewMesh->GetName(), *GetName(), *CurrentMesh->GetName());
+		return;
+	}
+
+	if (NewMesh != CurrentMesh) MeshComponent->SetSkeletalMesh(NewMesh, false);
+
+	MeshComponent->EmptyOverrideMaterials();
+	if (Skin)
+	{
+		for (int32 i = 0; i < Skin->Materials.Num(); i++)
+		{
+			UMaterialInterface* Material = Skin->Materials[i].Get();
+			if (Material) MeshComponent->SetMaterial(i, Material);
+		}
+	}
+
+	// Skins stream in after BeginPlay, so the kill-cam's ghost has to be told
+	AScavengerKillCam* KillCam = AScavengerKillCam::Get(GetWorld());
+	if (KillCam && HasActorBegunPlay()) KillCam->Track(this);
+}
+
 void AScavengerCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime); // Call parent class tick function  
 	//Set blueprint aiming value every frame. May change this later in case I need to time it differently
 	//IsAimingCPP = Aiming;
 
+	// Server RPC setters received since the last tick
+	if (Role == ROLE_Authority) ApplyCoalescedRpcs();
+
+	// Every viewer keeps the character hash current for aim assist, dedicated servers have no use for it
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		AScavengerGameState* GameState = AScavengerGameState::Get(this);
+		if (GameState)
+		{
+			GameState->GetCharacterHash().Update(this);
+			InCharacterHash = true;
+		}
+	}
+
 	UpdateCamera();
 	UpdateAiming();
+	if (IsLocallyControlled() && MyPC) UpdateAimAssist();
+	if (Role == ROLE_SimulatedProxy) UpdateRemoteAimState();
+	UpdateCoverBlends(DeltaTime);
+	if (FScavengerInputLatency::IsEnabled() && IsLocallyControlled()) ObserveInputLatency();
+
+	if (!ReportedFirstFrame && IsLocallyControlled())
+	{
+		UScavengerGameInstance* GameInstance = UScavengerGameInstance::Get(this);
+		if (GameInstance && GameInstance->IsPreloadComplete())
+		{
+			GameInstance->NotifyFirstPlayableFrame();
+			ReportedFirstFrame = true;
+		}
+	}
 
 	if (GetCharacterMovement()->IsWalking()) OnGround = true;
 	else OnGround = false;
@@ -539,145 +1036,218 @@ void AScavengerCharacter::Tick(float DeltaTime)
 	{
 		ExecuteDash();
 	}
-	else if (DashCooldownTimer < DashCooldown) DashCooldownTimer++;
+	else ScavengerCover::TickDashCooldown(DashCooldownTimer, DashCooldown);
 
 	FVector MoveVector = GetMovementComponent()->GetLastInputVector();
 	MoveVector.Normalize();
 }
 
-void AScavengerCharacter::StickToCover()
+void AScavengerCharacter::ObserveInputLatency()
 {
-	FVector MoveVector = GetMovementComponent()->GetLastInputVector();
+	// Aim shows locally once the camera has pulled in (or back out), the server's answer is IsAimingCPP
+	if (GetCameraBoom() && FMath::Abs(GetCameraBoom()->TargetArmLength - TargetAimZoomDistance) <= CameraTrackSpeed)
+	{
+		FScavengerInputLatency::Observe(TargetAimZoomDistance == AimZoomDistance ? EScavengerInputAction::Aim : EScavengerInputAction::StopAim, EScavengerLatencyStage::Local);
+	}
+	FScavengerInputLatency::Observe(IsAimingCPP ? EScavengerInputAction::Aim : EScavengerInputAction::StopAim, EScavengerLatencyStage::Ack);
 
-	if (MoveVector != FVector::ZeroVector)
+	// Walk speed is set by the server, so even the local effect of running waits on a round trip
+	const float Speed = GetCharacterMovement()->MaxWalkSpeed;
+	if (Speed == RunSpeed) FScavengerInputLatency::Observe(EScavengerInputAction::Run, EScavengerLatencyStage::Local);
+	else if (Speed == WalkSpeed) FScavengerInputLatency::Observe(EScavengerInputAction::StopRun, EScavengerLatencyStage::Local);
+	FScavengerInputLatency::Observe(Running ? EScavengerInputAction::Run : EScavengerInputAction::StopRun, EScavengerLatencyStage::Ack);
+
+	// Cover isn't predicted, it shows up locally when the server's InCoverCPP arrives
+	if (InCoverCPP)
 	{
-		//Check input for left or right movement to flip animation direction
-		if (AngleBetween(MoveVector, GetActorRightVector()) < AngleBetween(MoveVector, -GetActorRightVector()))
-		{
-			CoverFacingRightCPP = true;
-			ServerSetCoverState(true, IsPoppedOutCPP);
-		}
-		else
-		{
-			CoverFacingRightCPP = false;
-			ServerSetCoverState(false, IsPoppedOutCPP);
-		}
+		FScavengerInputLatency::Observe(EScavengerInputAction::TakeCover, EScavengerLatencyStage::Local);
+		FScavengerInputLatency::Observe(EScavengerInputAction::TakeCover, EScavengerLatencyStage::Ack);
 	}
 
-	if (Role == ROLE_Authority)
+	if (!GetVelocity().IsZero()) FScavengerInputLatency::Observe(EScavengerInputAction::Move, EScavengerLatencyStage::Local);
+
+	HadMoveInput = HasMoveInput;
+	HasMoveInput = false;
+}
+
+void AScavengerCharacter::UpdateRemoteAimState()
+{
+	if (AimSnapshots.Num() == 0) return;
+
+	const float RenderTime = GetWorld()->GetTimeSeconds() - InterpolationDelay;
+
+	// Drop a snapshot once the one after it is already due
+	while (AimSnapshots.Num() > 1 && AimSnapshots[1].Time <= RenderTime) AimSnapshots.RemoveAt(0);
+
+	const FAimSnapshot& From = AimSnapshots[0];
+	if (RenderTime < From.Time) return;
+
+	CoverFacingRightCPP = From.CoverFacingRight;
+	IsPoppedOutCPP = From.PoppedOut;
+
+	if (AimSnapshots.Num() == 1)
+	{
+		// Nothing newer yet, hold rather than guess
+		AimPitchCPP = From.AimPitch;
+		AimYawCPP = From.AimYaw;
+		return;
+	}
+
+	const FAimSnapshot& To = AimSnapshots[1];
+	const float Alpha = FMath::Clamp((RenderTime - From.Time) / FMath::Max(To.Time - From.Time, KINDA_SMALL_NUMBER), 0.0f, 1.0f);
+	AimPitchCPP = FMath::Lerp(From.AimPitch, To.AimPitch, Alpha);
+	AimYawCPP = FRotator::NormalizeAxis(From.AimYaw + FMath::FindDeltaAngleDegrees(From.AimYaw, To.AimYaw) * Alpha);
+}
+
+void AScavengerCharacter::UpdateCoverBlends(float DeltaTime)
+{
+	CoverFacingBlendCPP = FMath::FInterpConstantTo(CoverFacingBlendCPP, CoverFacingRightCPP ? 1.0f : 0.0f, DeltaTime, CoverBlendSpeed);
+	PopOutBlendCPP = FMath::FInterpConstantTo(PopOutBlendCPP, IsPoppedOutCPP ? 1.0f : 0.0f, DeltaTime, CoverBlendSpeed);
+}
+
+void AScavengerCharacter::PushAimSnapshot()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	ReceivedAim.Time = Now;
+
+	// Every property from one update notifies separately, they all belong to the same snapshot
+	if (AimSnapshots.Num() > 0 && AimSnapshots.Last().Time == Now)
 	{
-		//DrawDebugLine(GetWorld(), GetActorLocation() + (GetActorUpVector() * 20.0), GetActorLocation() + (GetActorUpVector() * 20.0) + CurrentCoverDirection*40.0f, FColor(255, 0, 0), false, 0.0f, 0, 10.0f);
+		AimSnapshots.Last() = ReceivedAim;
+		return;
+	}
 
-		//Set up Query Parameters
-		FCollisionQueryParams TraceParameters(FName(TEXT("")), false, GetOwner());
+	// After a quiet spell the held snapshot is long past, blend from it starting now instead of jumping
+	if (AimSnapshots.Num() == 1 && AimSnapshots[0].Time < Now - InterpolationDelay) AimSnapshots[0].Time = Now - InterpolationDelay;
 
-		// Ray-Cast our Grabber Ray
-		FHitResult LeftHit;
-		FHitResult RightHit;
+	if (AimSnapshots.Num() >= MaxAimSnapshots) AimSnapshots.RemoveAt(0);
+	AimSnapshots.Add(ReceivedAim);
+}
 
-		//FVector LocationPlusMovementLeft = GetActorLocation() + (GetMovementComponent()->GetLastInputVector()) + GetActorRightVector() * -41.0;
-		//FVector LocationPlusMovementRight = GetActorLocation() + (GetMovementComponent()->GetLastInputVector()) + GetActorRightVector() * 41.0;
+// Simulated proxies keep showing the old value and queue the new one for UpdateRemoteAimState
+void AScavengerCharacter::OnRep_AimPitch(float PreviousAimPitch)
+{
+	if (Role != ROLE_SimulatedProxy) return;
+	ReceivedAim.AimPitch = AimPitchCPP;
+	AimPitchCPP = PreviousAimPitch;
+	PushAimSnapshot();
+}
 
-		FVector LocationPlusMovementLeft = GetActorLocation() + GetActorRightVector() * -CoverHalfWidth;
-		FVector LocationPlusMovementRight = GetActorLocation() + GetActorRightVector() * CoverHalfWidth;
+void AScavengerCharacter::OnRep_AimYaw(float PreviousAimYaw)
+{
+	if (Role != ROLE_SimulatedProxy) return;
+	ReceivedAim.AimYaw = AimYawCPP;
+	AimYawCPP = PreviousAimYaw;
+	PushAimSnapshot();
+}
 
-		GetWorld()->LineTraceSingleByObjectType(
-			LeftHit,
-			LocationPlusMovementLeft,
-			LocationPlusMovementLeft + CurrentCoverDirection * CoverSenseDistance,
-			FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-			TraceParameters
-		);
+void AScavengerCharacter::OnRep_CoverFacingRight(bool PreviousCoverFacingRight)
+{
+	if (Role != ROLE_SimulatedProxy) return;
+	ReceivedAim.CoverFacingRight = CoverFacingRightCPP;
+	CoverFacingRightCPP = PreviousCoverFacingRight;
+	PushAimSnapshot();
+}
 
-		GetWorld()->LineTraceSingleByObjectType(
-			RightHit,
-			LocationPlusMovementRight,
-			LocationPlusMovementRight + CurrentCoverDirection * CoverSenseDistance,
-			FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-			TraceParameters
-		);
+void AScavengerCharacter::OnRep_PoppedOut(bool PreviousPoppedOut)
+{
+	if (Role != ROLE_SimulatedProxy) return;
+	ReceivedAim.PoppedOut = IsPoppedOutCPP;
+	IsPoppedOutCPP = PreviousPoppedOut;
+	PushAimSnapshot();
+}
 
-		//DrawDebugLine(GetWorld(), LocationPlusMovementLeft, LocationPlusMovementLeft + CurrentCoverDirection * CoverSenseDistance, FColor(0, 255, 0), false, 0.0f, 0, 3.0f);
-		//DrawDebugLine(GetWorld(), LocationPlusMovementRight, LocationPlusMovementRight + CurrentCoverDirection * CoverSenseDistance, FColor(0, 255, 0), false, 0.0f, 0, 3.0f);
+FVector AScavengerCharacter::GetCoverAlongDirection() const
+{
+	return FRotationMatrix(CurrentCoverDirection.Rotation()).GetUnitAxis(EAxis::Y);
+}
 
-		if (LeftHit.GetComponent())
-		{
-			if (LeftHit.GetComponent()->ComponentHasTag("Cover"))
-			{
-				OnEdgeLeft = false;
-			}
-			else
-			{
-				// No cover found! Must be at the end. 
-				OnEdgeLeft = true;
-			}
-		}
-		else
-		{
-			// No cover found! Must be at the end. 
-			OnEdgeLeft = true;
-		}
+void AScavengerCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
 
-		if (RightHit.GetComponent())
-		{
-			if (RightHit.GetComponent()->ComponentHasTag("Cover"))
-			{
-				OnEdgeRight = false;
-			}
-			else
-			{
-				// No cover found! Must be at the end. 
-				OnEdgeRight = true;
-			}
-		}
-		else
+	const bool CoverReplication = InCoverCPP && bReplicateMovement;
+	if (CoverReplication)
+	{
+		const FVector Along = GetCoverAlongDirection();
+		const FVector FromAnchor = GetActorLocation() - CoverMovement.Anchor;
+
+		CoverMovement.Offset = FMath::Clamp(FMath::RoundToInt(FVector::DotProduct(FromAnchor, Along)), -32767, 32767);
+		CoverMovement.Rise = FMath::Clamp(FMath::RoundToInt(FromAnchor.Z), -32767, 32767);
+		CoverMovement.Speed = FMath::Clamp(FMath::RoundToInt(FVector::DotProduct(GetVelocity(), Along)), -32767, 32767);
+	}
+
+	// Full movement goes back out as soon as we leave cover
+	DOREPLIFETIME_ACTIVE_OVERRIDE(AActor, ReplicatedMovement, bReplicateMovement && !CoverReplication);
+	DOREPLIFETIME_ACTIVE_OVERRIDE(AScavengerCharacter, CoverMovement, CoverReplication);
+}
+
+void AScavengerCharacter::OnRep_CoverMovement()
+{
+	if (Role != ROLE_SimulatedProxy || !InCoverCPP) return;
+
+	// Rebuilt into the engine's replicated movement so it takes the usual smoothing path
+	const FVector Along = GetCoverAlongDirection();
+	ReplicatedMovement.Location = CoverMovement.Anchor + Along * CoverMovement.Offset + FVector(0.0f, 0.0f, CoverMovement.Rise);
+	ReplicatedMovement.Rotation = CurrentCoverDirection.Rotation();
+	ReplicatedMovement.LinearVelocity = Along * CoverMovement.Speed;
+	ReplicatedMovement.AngularVelocity = FVector::ZeroVector;
+	OnRep_ReplicatedMovement();
+}
+
+void AScavengerCharacter::StickToCover()
+{
+	FVector MoveVector = GetMovementComponent()->GetLastInputVector();
+
+	if (MoveVector != FVector::ZeroVector)
+	{
+		//Check input for left or right movement to flip animation direction
+		const bool FacingRight = ScavengerCover::IsFacingRight(ToCoverVec(MoveVector), ToCoverVec(GetActorRightVector()));
+		if (FacingRight != CoverFacingRightCPP)
 		{
-			// No cover found! Must be at the end. 
-			OnEdgeRight = true;
+			CoverFacingRightCPP = FacingRight;
+			ServerSetCoverState(FacingRight, IsPoppedOutCPP);
 		}
+	}
+
+	if (Role == ROLE_Authority)
+	{
+		const FCharacterCoverQuery Query(this);
+		const ScavengerCover::FVec3 Right = ToCoverVec(GetActorRightVector());
+		const ScavengerCover::FVec3 CoverDirection = ToCoverVec(CurrentCoverDirection);
+		const ScavengerCover::FEdgeState PreviousEdges = CoverEdges;
+
+		// Anything other than cover either side of us means we've walked off the end
+		ScavengerCover::ApplyEdgeProbe(ScavengerCover::ProbeEdges(Query, ToCoverVec(GetActorLocation()), Right, CoverDirection, CoverHalfWidth, CoverSenseDistance), CoverEdges);
 
-		if (OnEdgeLeft || OnEdgeRight)
+		if (CoverEdges.IsOnEdge())
 		{
 			SetActorLocation(LastFramePosition, false);
 			if (Role < ROLE_Authority) ServerAdjustActorLocation(LastFramePosition);
 		}
 
-		if (OnEdgeLeft == true && OnEdgeRight == true)
+		if (CoverEdges.IsOffCover())
 		{
-			if (Role == ROLE_Authority) ExitCover();
+			if (Role == ROLE_Authority)
+			{
+				AScavengerRpcLimiter::FExemptScope Exempt;
+				ExitCover();
+			}
 		}
 
 		// Ray cast a second time, to see if we are close enough to the edges to pop out
+		ScavengerCover::ApplyPopOutProbe(ScavengerCover::ProbeEdges(Query, ToCoverVec(GetActorLocation()), Right, CoverDirection, CoverHalfWidth * 1.25f, CoverSenseDistance), CoverEdges);
 
-		LocationPlusMovementLeft = GetActorLocation() + GetActorRightVector() * CoverHalfWidth * -1.25;
-		LocationPlusMovementRight = GetActorLocation() + GetActorRightVector() * CoverHalfWidth * 1.25;
-
-		GetWorld()->LineTraceSingleByObjectType(
-			LeftHit,
-			LocationPlusMovementLeft,
-			LocationPlusMovementLeft + CurrentCoverDirection * CoverSenseDistance,
-			FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-			TraceParameters
-		);
-
-		GetWorld()->LineTraceSingleByObjectType(
-			RightHit,
-			LocationPlusMovementRight,
-			LocationPlusMovementRight + CurrentCoverDirection * CoverSenseDistance,
-			FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-			TraceParameters
-		);
-
-		if (!LeftHit.GetComponent()) EdgeAdjustedLeft = true;
-		else EdgeAdjustedLeft = false;
-
-		if (!RightHit.GetComponent()) EdgeAdjustedRight = true;
-		else EdgeAdjustedRight = false;
+		if (CoverEdges.AdjustedLeft != PreviousEdges.AdjustedLeft || CoverEdges.AdjustedRight != PreviousEdges.AdjustedRight ||
+			CoverEdges.OnEdgeLeft != PreviousEdges.OnEdgeLeft || CoverEdges.OnEdgeRight != PreviousEdges.OnEdgeRight)
+		{
+			SCAV_TRACE(Edges, this, CoverEdges.AdjustedLeft, CoverEdges.AdjustedRight, CoverEdges.OnEdgeLeft, CoverEdges.OnEdgeRight);
+		}
 
-		ClientUpdateEdges(EdgeAdjustedLeft, EdgeAdjustedRight);
+		ClientUpdateEdges(CoverEdges.AdjustedLeft, CoverEdges.AdjustedRight);
 
 		//Update LastFramePosition
-		if (!OnEdgeLeft && !OnEdgeRight)
+		if (!CoverEdges.IsOnEdge())
 			LastFramePosition = GetActorLocation();
 
 		if (IsCoverStandable()) CrouchedCPP = false;
@@ -700,6 +1270,9 @@ void AScavengerCharacter::Jump()
 
 void AScavengerCharacter::StartAiming_Implementation()
 {
+	SCAV_COUNT_RPC(StartAiming, 0);
+	if (!BeginServerRpc(EScavengerRpc::StartAiming)) return;
+
 	//UE_LOG(LogTemp, Warning, TEXT("StartAiming"));
 	
 	if (Running) return;
@@ -714,10 +1287,14 @@ void AScavengerCharacter::StartAiming_Implementation()
 		bUseControllerRotationYaw = true;
 	}
 	IsAimingCPP = true;
+	SCAV_TRACE(AimStart, this);
 }
 
 void AScavengerCharacter::StopAiming_Implementation()
 {
+	SCAV_COUNT_RPC(StopAiming, 0);
+	if (!BeginServerRpc(EScavengerRpc::StopAiming)) return;
+
 	//UE_LOG(LogTemp, Warning, TEXT("StopAiming"));
 	if (!InCoverCPP)
 	{
@@ -731,20 +1308,22 @@ void AScavengerCharacter::StopAiming_Implementation()
 	//UE_LOG(LogTemp, Warning, TEXT("Stop Aiming (Server)!"));
 	IsAimingCPP = false;
 	IsPoppedOutCPP = false;
+	SCAV_TRACE(AimStop, this);
 }
 
 void AScavengerCharacter::ExitCover_Implementation()
 {
+	SCAV_COUNT_RPC(ExitCover, 0);
+	if (!BeginServerRpc(EScavengerRpc::ExitCover)) return;
+	SCAV_TRACE(ExitCover, this);
+
 	//UE_LOG(LogTemp, Warning, TEXT("ExitCover Called"));
 	CrouchedCPP = false;
 	IsPoppedOutCPP = false;
 	EnterCoverTimer = 0;
 
 	InCoverCPP = false;
-	OnEdgeLeft = false;
-	OnEdgeRight = false;
-	EdgeAdjustedLeft = false;
-	EdgeAdjustedRight = false;
+	CoverEdges = ScavengerCover::FEdgeState();
 
 	if (MyMove)
 	{
@@ -761,28 +1340,14 @@ void AScavengerCharacter::ExitCover_Implementation()
 
 bool AScavengerCharacter::IsCoverStandable()
 {
-	//Set up Query Parameters
-	FCollisionQueryParams TraceParameters(FName(TEXT("")), false, GetOwner());
-
-	// Ray-Cast our Grabber Ray
-	FHitResult HeadHit;
-
-	FVector HeadTest = GetActorLocation() + (GetActorUpVector() * 20.0);
-
-	GetWorld()->LineTraceSingleByObjectType(
-		HeadHit,
-		HeadTest,
-		HeadTest + CurrentCoverDirection * CoverSenseDistance,
-		FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-		TraceParameters
-	);
-
-	if (HeadHit.GetComponent()) return true;
-	return false;
+	return ScavengerCover::IsCoverStandable(FCharacterCoverQuery(this), ToCoverVec(GetActorLocation()), ToCoverVec(GetActorUpVector()), ToCoverVec(CurrentCoverDirection), CoverHeadHeight, CoverSenseDistance);
 }
 
 void AScavengerCharacter::EnterCover_Implementation(FVector LastMoveVector, FVector CurrentCover)
 {
+	SCAV_COUNT_RPC(EnterCover, 2 * sizeof(FVector));
+	if (!BeginServerRpc(EScavengerRpc::EnterCover)) return;
+
 	CurrentCoverDirection = CurrentCover;
 	if (!OnGround) return;
 	LastFramePosition = GetActorLocation();
@@ -791,41 +1356,25 @@ void AScavengerCharacter::EnterCover_Implementation(FVector LastMoveVector, FVec
 	
 	//UE_LOG(LogTemp, Warning, TEXT("Made it past the initial checks"));
 
-	StartWalking();
+	{
+		AScavengerRpcLimiter::FExemptScope Exempt;
+		StartWalking();
+	}
 
 	EnterCoverTimer = 0;
-	//Set up Query Parameters
-	FCollisionQueryParams TraceParameters(FName(TEXT("")), false, GetOwner());
-
-	// Ray-Cast our Grabber Ray
-	FHitResult LeftHit;
-	FHitResult RightHit;
-
-	FVector LocationPlusMovementLeft = GetActorLocation() + (LastMoveVector) + GetActorRightVector() * -CoverHalfWidth;
-	FVector LocationPlusMovementRight = GetActorLocation() + (LastMoveVector) + GetActorRightVector() * CoverHalfWidth;
-
-	GetWorld()->LineTraceSingleByObjectType(
-		LeftHit,
-		LocationPlusMovementLeft,
-		LocationPlusMovementLeft + CurrentCover * CoverSenseDistance,
-		FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-		TraceParameters
-	);
-
-	GetWorld()->LineTraceSingleByObjectType(
-		RightHit,
-		LocationPlusMovementRight,
-		LocationPlusMovementRight + CurrentCover * CoverSenseDistance,
-		FCollisionObjectQueryParams(ECollisionChannel::ECC_WorldStatic),
-		TraceParameters
-	);
+
+	const ScavengerCover::FEdgeProbe Probe = ScavengerCover::ProbeEdges(FCharacterCoverQuery(this), ToCoverVec(GetActorLocation() + LastMoveVector), ToCoverVec(GetActorRightVector()), ToCoverVec(CurrentCover), CoverHalfWidth, CoverSenseDistance);
 
 	//UE_LOG(LogTemp, Warning, TEXT("Cast the rays..."));
 
-	if (LeftHit.GetComponent() && RightHit.GetComponent())
+	if (Probe.Left != ScavengerCover::ECoverHit::None && Probe.Right != ScavengerCover::ECoverHit::None)
 	{
 		//SetActorRotation(GetActorRotation().)
 		InCoverCPP = true;
+		SCAV_TRACE(EnterCover, this, CurrentCover.X, CurrentCover.Y, CurrentCover.Z);
+		// Whole centimetres, as the anchor is quantized, so proxies rebuild the same position
+		const FVector Location = GetActorLocation();
+		CoverMovement.Anchor = FVector(FMath::RoundToFloat(Location.X), FMath::RoundToFloat(Location.Y), FMath::RoundToFloat(Location.Z));
 		//UE_LOG(LogTemp, Warning, TEXT("Hit cover!"));
 		if (MyMove)
 		{
@@ -850,16 +1399,6 @@ void AScavengerCharacter::EnterCover_Implementation(FVector LastMoveVector, FVec
 	return InCover;
 }*/
 
-float AScavengerCharacter::AngleBetween(FVector a, FVector b)
-{
-	//UE_LOG(LogTemp, Warning, TEXT("Vectors: %s, %s"), *a.ToString(), *b.ToString());
-	float ThisIsSparta;
-	ThisIsSparta = FMath::RadiansToDegrees(acosf(FVector::DotProduct(a, b)));
-
-	//UE_LOG(LogTemp, Warning, TEXT("%s, %s - This is: %f"), *a.ToString(), *b.ToString(), ThisIsSparta);
-	return ThisIsSparta;
-}
-
 void AScavengerCharacter::LocalStartAiming()
 {
 	if (Running) return;
@@ -867,7 +1406,7 @@ void AScavengerCharacter::LocalStartAiming()
 
 	if (InCoverCPP)
 	{
-		if (EdgeAdjustedLeft)
+		if (CoverEdges.AdjustedLeft)
 		{
 			TargetAimOffsetAmount = -AimOffsetAmount;
 
@@ -877,7 +1416,7 @@ void AScavengerCharacter::LocalStartAiming()
 			ServerSetCoverState(CoverFacingRightCPP, IsPoppedOutCPP);
 			
 		}
-		else if (EdgeAdjustedRight)
+		else if (CoverEdges.AdjustedRight)
 		{
 			TargetAimOffsetAmount = AimOffsetAmount;
 			
@@ -931,49 +1470,131 @@ void AScavengerCharacter::LocalStopAiming()
 
 }
 
-// Client to Server variable setters
+bool AScavengerCharacter::TakeRpcBudget(EScavengerRpc Rpc)
+{
+	AScavengerRpcLimiter* Limiter = AScavengerRpcLimiter::Get(GetWorld());
+	return !Limiter || Limiter->Allow(this, Rpc);
+}
+
+bool AScavengerCharacter::BeginServerRpc(EScavengerRpc Rpc)
+{
+	if (!TakeRpcBudget(Rpc)) return false;
+
+	// Setters sent before this call land first, as they would have unbatched
+	ApplyCoalescedRpcs();
+	return true;
+}
+
+void AScavengerCharacter::ApplyCoalescedRpcs()
+{
+	if (Coalesced.HasAimPitch) AimPitchCPP = Coalesced.AimPitch;
+	if (Coalesced.HasAimYaw) AimYawCPP = Coalesced.AimYaw;
+	if (Coalesced.HasCoverState)
+	{
+		CoverFacingRightCPP = Coalesced.CoverFacingRight;
+		IsPoppedOutCPP = Coalesced.PoppedOut;
+		SCAV_TRACE(CoverState, this, Coalesced.CoverFacingRight, Coalesced.PoppedOut);
+	}
+	if (Coalesced.HasLocation) SetActorLocation(Coalesced.Location, false);
+
+	Coalesced = FCoalescedRpcs();
+}
+
+// Client to Server variable setters. Only the latest of each is kept until the next tick (or the next
+// other RPC), so a burst of them costs one application; the locally controlled host applies at once.
 void AScavengerCharacter::ServerSetAimPitch_Implementation(float NewPitch)
 {
-	AimPitchCPP = NewPitch;
+	SCAV_COUNT_RPC(SetAimPitch, sizeof(float));
+	if (!TakeRpcBudget(EScavengerRpc::SetAimPitch)) return;
+
+	Coalesced.HasAimPitch = true;
+	Coalesced.AimPitch = NewPitch;
+	if (IsLocallyControlled()) ApplyCoalescedRpcs();
 }
 
 void AScavengerCharacter::ServerSetAimYaw_Implementation(float NewYaw)
 {
-	AimYawCPP = NewYaw;
+	SCAV_COUNT_RPC(SetAimYaw, sizeof(float));
+	if (!TakeRpcBudget(EScavengerRpc::SetAimYaw)) return;
+
+	Coalesced.HasAimYaw = true;
+	Coalesced.AimYaw = NewYaw;
+	if (IsLocallyControlled()) ApplyCoalescedRpcs();
 }
 
 void AScavengerCharacter::ServerSetCoverState_Implementation(bool FacingRight, bool PoppedOut)
 {
-	CoverFacingRightCPP = FacingRight;
-	IsPoppedOutCPP = PoppedOut;
+	SCAV_COUNT_RPC(SetCoverState, 2 * sizeof(bool));
+	if (!TakeRpcBudget(EScavengerRpc::SetCoverState)) return;
+
+	Coalesced.HasCoverState = true;
+	Coalesced.CoverFacingRight = FacingRight;
+	Coalesced.PoppedOut = PoppedOut;
+	if (IsLocallyControlled()) ApplyCoalescedRpcs();
 }
 
 void AScavengerCharacter::ServerAdjustActorLocation_Implementation(FVector NewPos)
 {
-	SetActorLocation(NewPos, false);
+	SCAV_COUNT_RPC(AdjustActorLocation, sizeof(FVector));
+	if (!TakeRpcBudget(EScavengerRpc::AdjustActorLocation)) return;
+
+	Coalesced.HasLocation = true;
+	Coalesced.Location = NewPos;
+	if (IsLocallyControlled()) ApplyCoalescedRpcs();
 }
 
 // Server to Client variable setters
 void AScavengerCharacter::ClientUpdateWalkSpeed_Implementation(float NewSpeed)
 {
+	SCAV_COUNT_RPC(ClientUpdateWalkSpeed, sizeof(float));
+
 	GetCharacterMovement()->MaxWalkSpeed = NewSpeed;
 }
 
 void AScavengerCharacter::ClientOrientRotationToMovement_Implementation(bool Incoming)
 {
+	SCAV_COUNT_RPC(ClientOrientRotationToMovement, sizeof(bool));
+
 	if (MyMove) MyMove->bOrientRotationToMovement = Incoming;
 }
 
+void AScavengerCharacter::ClientResetForRound_Implementation()
+{
+	SCAV_COUNT_RPC(ClientResetForRound, 0);
+
+	// Keys held through the round change would otherwise come back as running or aiming
+	Aiming = false;
+	RunKeyPressed = false;
+
+	// What LocalStopAiming leaves once aiming ends out of cover
+	TargetAimZoomDistance = StoredAimZoomDistance;
+	TargetAimOffsetAmount = 0.0f;
+	if (MyMove) MyMove->bOrientRotationToMovement = true;
+	bUseControllerRotationYaw = false;
+
+	// Snapped rather than eased back, the view has just been teleported anyway
+	if (GetCameraBoom())
+	{
+		GetCameraBoom()->TargetArmLength = TargetAimZoomDistance;
+		GetCameraBoom()->SocketOffset.Y = TargetAimOffsetAmount;
+	}
+}
+
 void AScavengerCharacter::ClientUpdateEdges_Implementation(bool LeftEdge, bool RightEdge)
 {
-	EdgeAdjustedLeft = LeftEdge;
-	EdgeAdjustedRight = RightEdge;
+	SCAV_COUNT_RPC(ClientUpdateEdges, 2 * sizeof(bool));
+
+	if (LeftEdge != CoverEdges.AdjustedLeft || RightEdge != CoverEdges.AdjustedRight) SCAV_TRACE(Edges, this, LeftEdge, RightEdge);
+
+	CoverEdges.AdjustedLeft = LeftEdge;
+	CoverEdges.AdjustedRight = RightEdge;
 }
 
-// Network Validation
+// Network Validation. Only values an honest client can't produce fail, since failing disconnects;
+// call rates are the RPC limiter's business.
 bool AScavengerCharacter::ServerAdjustActorLocation_Validate(FVector NewPos)
 {
-	return true;
+	return !NewPos.ContainsNaN();
 }
 
 bool AScavengerCharacter::ServerSetCoverState_Validate(bool FacingRight, bool PoppedOut)
@@ -983,12 +1604,12 @@ bool AScavengerCharacter::ServerSetCoverState_Validate(bool FacingRight, bool Po
 
 bool AScavengerCharacter::ServerSetAimPitch_Validate(float NewPitch)
 {
-	return true;
+	return FMath::IsFinite(NewPitch);
 }
 
 bool AScavengerCharacter::ServerSetAimYaw_Validate(float NewYaw)
 {
-	return true;
+	return FMath::IsFinite(NewYaw);
 }
 
 bool AScavengerCharacter::StartRunning_Validate()
@@ -1003,7 +1624,7 @@ bool AScavengerCharacter::StartWalking_Validate()
 
 bool AScavengerCharacter::EnterCover_Validate(FVector LastMoveVector, FVector CurrentCover)
 {
-	return true;
+	return !LastMoveVector.ContainsNaN() && !CurrentCover.ContainsNaN();
 }
 
 bool AScavengerCharacter::ExitCover_Validate()
@@ -1034,4 +1655,9 @@ bool AScavengerCharacter::StopDash_Validate()
 bool AScavengerCharacter::Die_Validate()
 {
 	return true;
+}
+
+bool AScavengerCharacter::ServerFire_Validate(FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction, uint16 ShotId)
+{
+	return !Origin.ContainsNaN() && !Direction.ContainsNaN();
 }
\ No newline at end of file
@@ -4,15 +4,44 @@
 #include "GameFramework/Character.h"
 #include "DrawDebugHelpers.h"
 
-#include <gun.h>
+#include "ScavengerCoverCore.h"
+#include "ScavengerStats.h"
 
 #include "ScavengerCharacter.generated.h"
 
+// Movement sent to simulated proxies while in cover, in place of the full replicated movement.
+// The character can only slide along the wall, so its position is a distance along it from where it
+// entered cover. Facing rides on CoverFacingRightCPP, and only fields that change are sent.
+USTRUCT()
+struct FScavengerCoverMovement
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Where cover was entered, set once per stretch of cover
+	UPROPERTY()
+	FVector_NetQuantize Anchor = FVector::ZeroVector;
+
+	// Distance along the wall from Anchor, in cm, positive to the right when facing the wall
+	UPROPERTY()
+	int16 Offset = 0;
+
+	// Height above Anchor in cm, for cover on slopes
+	UPROPERTY()
+	int16 Rise = 0;
+
+	// Speed along the wall in cm/s, what proxies animate and extrapolate with
+	UPROPERTY()
+	int16 Speed = 0;
+};
+
 UCLASS(Config = game, ClassGroup = (Custom), meta = (BlueprintSpawnableComponent), Blueprintable, BlueprintType)
 class AScavengerCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	// Drives characters through scripted scenarios without a player
+	friend class UScavengerPerfCommandlet;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
@@ -64,6 +93,15 @@ class AScavengerCharacter : public ACharacter
 		virtual void Die();
 	bool Die_Validate();
 
+	// Server side death, records the kill in the combat feed
+	virtual void HandleDeath(AActor* Killer);
+
+	virtual void LocalFire();
+
+	UFUNCTION(Server, Reliable, WithValidation)
+		virtual void ServerFire(FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction, uint16 ShotId);
+	bool ServerFire_Validate(FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction, uint16 ShotId);
+
 	UFUNCTION(Server, Reliable, WithValidation)
 		virtual void ServerAdjustActorLocation(FVector NewPos);
 	bool ServerAdjustActorLocation_Validate(FVector NewPos);
@@ -85,6 +123,10 @@ class AScavengerCharacter : public ACharacter
 	UFUNCTION(Client, Reliable)
 		virtual void ClientOrientRotationToMovement(bool Incoming);
 
+	// Puts back the input and camera state only the owning client keeps
+	UFUNCTION(Client, Reliable)
+		virtual void ClientResetForRound();
+
 	UFUNCTION(Server, Reliable, WithValidation)
 		virtual void ServerSetCoverState(bool FacingRight, bool PoppedOut);
 		bool ServerSetCoverState_Validate(bool FacingRight, bool PoppedOut);
@@ -95,10 +137,21 @@ public:
 	// Tick method declaration
 	virtual void Tick(float DeltaTime);
 	virtual void BeginPlay();
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 
 	// Jump override to fix buggy UE code
 	virtual void Jump() override;
 
+	// Changes the cover entry and exit angle, keeping the cosine the checks use in step
+	void SetMaxCoverAngle(int Degrees);
+
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
+
 	//UFUNCTION(BlueprintCallable, Category = "Pawn|Character")
 	//bool IsInCover(); // Getter for cover state
 
@@ -113,8 +166,6 @@ public:
 	UFUNCTION()
 	virtual void OnHit(AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
-	float AngleBetween(FVector a, FVector b);
-
 	UPROPERTY(EditAnywhere, Category = Custom)
 	FVector2D CrosshairLocation;
 
@@ -130,27 +181,38 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
 	bool CrouchedCPP = false;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_CoverFacingRight, Category = Custom)
 	bool CoverFacingRightCPP = false;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
 	bool IsDashingCPP = false;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_PoppedOut, Category = Custom)
 	bool IsPoppedOutCPP = false;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
 	bool IsAimingCPP = false;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_IsDead, Category = Custom)
 	bool IsDeadCPP = false;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
+	float HealthCPP = 100.0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_AimPitch, Category = Custom)
 	float AimPitchCPP = 0.0;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_AimYaw, Category = Custom)
 	float AimYawCPP = 0.0;
 
+	// 0 facing left to 1 facing right, eased so cover turns blend rather than snap
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Custom)
+	float CoverFacingBlendCPP = 0.0;
+
+	// 0 behind cover to 1 fully popped out, eased the same way
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Custom)
+	float PopOutBlendCPP = 0.0;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, replicated, Category = Custom)
 	bool Running = false;
 
@@ -160,9 +222,20 @@ public:
 	UPROPERTY(EditAnywhere)
 	float WalkSpeed = 0.0;
 
+	UPROPERTY(EditAnywhere)
+	float MaxHealth = 100.0;
+
 	UPROPERTY(Replicated)
 	FVector CurrentCoverDirection;
 
+	// Replaces ReplicatedMovement for simulated proxies while InCoverCPP is set
+	UPROPERTY(ReplicatedUsing = OnRep_CoverMovement)
+	FScavengerCoverMovement CoverMovement;
+
+	// Index into AScavengerSkinManager::Skins plus one, so 0 is the Blueprint's own mesh
+	UPROPERTY(ReplicatedUsing = OnRep_SkinIndex)
+	uint8 SkinIndex = 0;
+
 	UPROPERTY(Replicated)
 	FVector DashDirection;
 
@@ -175,19 +248,53 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "BP Classes")
 	UClass* WeaponBPClass;
 
+	// Held weapon, replicated through this character rather than as an actor of its own
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
+	class UScavengerWeaponComponent* Weapon;
+
+	// Server side. Dresses this character in skin SkinIndex of AScavengerSkinManager::Skins, 0 for the Blueprint's own mesh.
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Skin)
+	void SetSkin(int32 NewSkinIndex);
+
+	// Server side. Brings this character back alive at Location for a new round instead of spawning a new one
+	void ResetForRound(const FVector& Location, const FRotator& Rotation);
+
+	// Called by the skin manager once the skin is resident, null puts the Blueprint's mesh back
+	void WearSkin(class UScavengerSkin* Skin);
+
+	// Skin this character has asked the skin manager for
+	int32 GetWornSkinIndex() const { return WornSkinIndex; }
+
 	// Object Pointers
 
-	AGun* EquippedWeapon;
 	APlayerController* MyPC;
 
 private:
 	bool RunKeyPressed = false;
 	bool Aiming = false;
 	bool OnGround = false;
-	bool OnEdgeLeft = false;
-	bool OnEdgeRight = false;
-	bool EdgeAdjustedLeft = false;
-	bool EdgeAdjustedRight = false;
+	ScavengerCover::FEdgeState CoverEdges;
+	bool ReportedFirstFrame = false;
+	int32 WornSkinIndex = 0;
+
+	// Whether either move axis was non-zero this frame and last, to spot the start of a move
+	bool HasMoveInput = false;
+	bool HadMoveInput = false;
+
+	// Aim and cover state received for a simulated proxy, shown InterpolationDelay seconds late
+	struct FAimSnapshot
+	{
+		float Time = 0.0f;
+		float AimPitch = 0.0f;
+		float AimYaw = 0.0f;
+		bool CoverFacingRight = false;
+		bool PoppedOut = false;
+	};
+	TArray<FAimSnapshot, TInlineAllocator<8>> AimSnapshots;
+	FAimSnapshot ReceivedAim;
+
+	float LastSentAimPitch = 0.0;
+	float LastSentAimYaw = 0.0;
 
 	FVector LastFramePosition;
 
@@ -195,8 +302,13 @@ private:
 	int DashTimer = 0;
 	int DashCooldownTimer = 0;
 
-	int NetworkTickUpdateTimer = 0; //Counter for network updates
-	int NetworkTickUpdateFrequency = 10; //Time in ticks between network update pushes
+	// Seconds between aim updates to the server, whatever the frame rate. The ServerSetAim limits in
+	// DefaultGame.ini are sized from this, so raise them if it goes down.
+	UPROPERTY(EditAnywhere)
+	float AimSendInterval = 0.1f;
+	float NextAimSendTime = 0.0f;
+	int AimResendTimer = 0;
+	int AimResendFrequency = 10; // Aim updates after which unchanged aim goes out again, in case the last one was lost
 
 	// Number of frames to dash, when dash is executed
 	UPROPERTY(EditAnywhere)
@@ -242,6 +354,57 @@ private:
 	UPROPERTY(EditAnywhere)
 	float AimDistance = 500.0;
 
+	// Furthest a target can be and still pull on a gamepad player's aim
+	UPROPERTY(EditAnywhere, Category = AimAssist)
+	float AimAssistRange = 3000.0;
+
+	// Distance off the crosshair ray a target still gets assist at, full strength on the ray itself
+	UPROPERTY(EditAnywhere, Category = AimAssist)
+	float AimAssistRadius = 150.0;
+
+	// Turn and look rate scale with the crosshair right on a target
+	UPROPERTY(EditAnywhere, Category = AimAssist)
+	float AimAssistSlowdown = 0.4;
+
+	// Share of a target's movement across the view the camera follows while the stick is held
+	UPROPERTY(EditAnywhere, Category = AimAssist)
+	float AimAssistFriction = 0.5;
+
+	// Characters nearest the crosshair ray weighed per frame, however many are in the match
+	UPROPERTY(EditAnywhere, Category = AimAssist)
+	int32 AimAssistMaxCandidates = 8;
+
+	// Seconds remote aim and cover state is held back so there is always a later snapshot to blend towards
+	UPROPERTY(EditAnywhere)
+	float InterpolationDelay = 0.15;
+
+	// Rate the cover facing and pop-out blends move at, in full transitions per second
+	UPROPERTY(EditAnywhere)
+	float CoverBlendSpeed = 6.0;
+
+	// Furthest a client-reported muzzle may be from the server's before it's ignored
+	UPROPERTY(EditAnywhere)
+	float MaxMuzzleError = 100.0;
+
+	// Furthest in degrees a client's shot direction may be from the server's view of its aim before
+	// it's pulled back towards it
+	UPROPERTY(EditAnywhere)
+	float MaxAimError = 30.0;
+
+	// Where the crosshair ray landed this frame, what shots are aimed at
+	FVector AimTargetLocation = FVector::ZeroVector;
+
+	// Character the crosshair is on for aim assist, and how close to it (0 to 1)
+	TWeakObjectPtr<AScavengerCharacter> AimAssistTarget;
+	float AimAssistStrength = 0.0;
+	// Direction from the camera to the target last frame, what friction measures its movement against
+	FRotator AimAssistLastTargetRotation = FRotator::ZeroRotator;
+	// Largest rate input seen since the last tick
+	float LookRateInput = 0.0;
+	TArray<AScavengerCharacter*> AimAssistCandidates;
+
+	bool InCharacterHash = false;
+
 	float TargetAimOffsetAmount = 0.0;
 	float CameraTrackSpeed = 8.0;
 
@@ -251,6 +414,9 @@ private:
 	UPROPERTY(EditAnywhere)
 	int MaxCoverAngle = 30; // The angle at which movement into a cover wall will result in entering cover
 
+	// Cosine of MaxCoverAngle, what the cover checks compare against. Set with MaxCoverAngle through SetMaxCoverAngle.
+	float CosMaxCoverAngle = 0.866f;
+
 	UCapsuleComponent* MyCapsule = nullptr;
 
 	UPROPERTY(Replicated)
@@ -261,6 +427,69 @@ private:
 
 	void UpdateCamera();
 	void UpdateAiming();
+	// Picks the aim assist target from the character hash and applies friction, locally controlled only
+	void UpdateAimAssist();
+	// Scale aim assist puts on rate (gamepad) look input this frame
+	float GetAimAssistRateScale() const;
+	// Completes latency samples whose effect shows this frame, locally controlled only
+	void ObserveInputLatency();
+	// Removes components only a viewer needs, dedicated servers only
+	void StripPresentationComponents();
+	void UpdateRemoteAimState();
+	void UpdateCoverBlends(float DeltaTime);
+
+	void PushAimSnapshot();
+
+	UFUNCTION()
+	void OnRep_AimPitch(float PreviousAimPitch);
+
+	UFUNCTION()
+	void OnRep_AimYaw(float PreviousAimYaw);
+
+	UFUNCTION()
+	void OnRep_CoverFacingRight(bool PreviousCoverFacingRight);
+
+	UFUNCTION()
+	void OnRep_PoppedOut(bool PreviousPoppedOut);
+
+	UFUNCTION()
+	void OnRep_CoverMovement();
+
+	UFUNCTION()
+	void OnRep_SkinIndex();
+
+	UFUNCTION()
+	void OnRep_IsDead();
+
+	// Undoes what dying did to the mesh, capsule and movement, on whichever machine it ran
+	void RestoreBody();
+
+	// Server RPCs take a token from the owning connection's budget first and do nothing without one.
+	// BeginServerRpc also applies coalesced setters first, to keep them in order with the call.
+	bool TakeRpcBudget(EScavengerRpc Rpc);
+	bool BeginServerRpc(EScavengerRpc Rpc);
+	void ApplyCoalescedRpcs();
+
+	// Latest aim, cover state and location setters received since they were last applied
+	struct FCoalescedRpcs
+	{
+		bool HasAimPitch = false;
+		bool HasAimYaw = false;
+		bool HasCoverState = false;
+		bool HasLocation = false;
+		float AimPitch = 0.0f;
+		float AimYaw = 0.0f;
+		bool CoverFacingRight = false;
+		bool PoppedOut = false;
+		FVector Location = FVector::ZeroVector;
+	};
+	FCoalescedRpcs Coalesced;
+
+	// Swaps the skin manager reference from the worn skin to SkinIndex
+	void UpdateSkin();
+
+	// Direction along the cover wall that CoverMovement offsets are measured in
+	FVector GetCoverAlongDirection() const;
 
 
 protected:
@@ -271,6 +500,12 @@ protected:
 	/** Called for side to side input */
 	void MoveRight(float Value);
 
+	/** Aim and run bindings, stamp the input for latency measurement before acting on it */
+	void AimPressed();
+	void AimReleased();
+	void RunPressed();
+	void RunReleased();
+
 	/** 
 	 * Called via input to turn at a given rate. 
 	 * @param Rate	This is a normalized rate, i.e. 1.0 means 100% of desired turn rate
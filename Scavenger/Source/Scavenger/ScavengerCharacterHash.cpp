@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerCharacterHash.h"
+#include "ScavengerCharacter.h"
+
+// Longest segment a query walks, in cells; anything past it is ignored
+static const int32 MaxQuerySteps = 16;
+
+void FScavengerCharacterHash::SetCellSize(float InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 100.0f);
+
+	// Rebucket whoever is already in
+	TArray<AScavengerCharacter*> Characters;
+	CellOf.GetKeys(Characters);
+	Cells.Reset();
+	CellOf.Reset();
+	for (AScavengerCharacter* Character : Characters) Update(Character);
+}
+
+FIntPoint FScavengerCharacterHash::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void FScavengerCharacterHash::Update(AScavengerCharacter* Character)
+{
+	if (!Character) return;
+
+	const FIntPoint Cell = GetCell(Character->GetActorLocation());
+	FIntPoint* Current = CellOf.Find(Character);
+	if (Current)
+	{
+		if (*Current == Cell) return;
+
+		auto* Bucket = Cells.Find(*Current);
+		if (Bucket)
+		{
+			Bucket->RemoveSingleSwap(Character);
+			if (Bucket->Num() == 0) Cells.Remove(*Current);
+		}
+		*Current = Cell;
+	}
+	else CellOf.Add(Character, Cell);
+
+	Cells.FindOrAdd(Cell).Add(Character);
+}
+
+void FScavengerCharacterHash::Remove(AScavengerCharacter* Character)
+{
+	FIntPoint Cell;
+	if (!CellOf.RemoveAndCopyValue(Character, Cell)) return;
+
+	auto* Bucket = Cells.Find(Cell);
+	if (Bucket)
+	{
+		Bucket->RemoveSingleSwap(Character);
+		if (Bucket->Num() == 0) Cells.Remove(Cell);
+	}
+}
+
+void FScavengerCharacterHash::QuerySegment(const FVector& Start, const FVector& End, float Radius, int32 MaxResults, const AActor* Ignore, TArray<AScavengerCharacter*>& OutCharacters) const
+{
+	OutCharacters.Reset();
+	if (MaxResults <= 0) return;
+
+	const FVector2D Start2D(Start);
+	const FVector2D Delta2D = FVector2D(End) - Start2D;
+	const int32 Steps = FMath::Min(FMath::CeilToInt(Delta2D.Size() / CellSize), MaxQuerySteps);
+	const int32 Reach = FMath::Clamp(FMath::CeilToInt(Radius / CellSize), 0, 1);
+
+	struct FHit
+	{
+		float DistSq;
+		AScavengerCharacter* Character;
+	};
+	TArray<FHit, TInlineAllocator<16>> Hits;
+	const float RadiusSq = FMath::Square(Radius);
+
+	// Sample the segment a cell apart and take the block of cells around each sample
+	TArray<FIntPoint, TInlineAllocator<64>> Visited;
+	for (int32 Step = 0; Step <= Steps; Step++)
+	{
+		const FVector2D Sample = Steps > 0 ? Start2D + Delta2D * ((float)Step / Steps) : Start2D;
+		const FIntPoint Center = GetCell(FVector(Sample, 0.0f));
+
+		for (int32 X = -Reach; X <= Reach; X++)
+		{
+			for (int32 Y = -Reach; Y <= Reach; Y++)
+			{
+				const FIntPoint Cell = Center + FIntPoint(X, Y);
+				if (Visited.Contains(Cell)) continue;
+				Visited.Add(Cell);
+
+				const auto* Bucket = Cells.Find(Cell);
+				if (!Bucket) continue;
+
+				// Cells hold everyone near the segment, the cap only applies to the living actually within Radius
+				for (AScavengerCharacter* Character : *Bucket)
+				{
+					if (Character == Ignore || Character->IsDeadCPP) continue;
+
+					const float DistSq = FMath::PointDistToSegmentSquared(Character->GetActorLocation(), Start, End);
+					if (DistSq <= RadiusSq) Hits.Add(FHit{ DistSq, Character });
+				}
+			}
+		}
+	}
+
+	Hits.Sort([](const FHit& A, const FHit& B) { return A.DistSq < B.DistSq; });
+	const int32 NumResults = FMath::Min(Hits.Num(), MaxResults);
+	for (int32 i = 0; i < NumResults; i++) OutCharacters.Add(Hits[i].Character);
+}
+
+SIZE_T FScavengerCharacterHash::GetAllocatedSize() const
+{
+	SIZE_T Size = Cells.GetAllocatedSize() + CellOf.GetAllocatedSize();
+	for (const auto& Bucket : Cells) Size += Bucket.Value.GetAllocatedSize();
+	return Size;
+}
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AScavengerCharacter;
+
+/**
+ * Characters bucketed into a uniform grid on the ground plane, so "who is near this line" looks at a
+ * handful of cells instead of every pawn in the world. Characters move between cells as they are
+ * updated, which is a map lookup unless the cell actually changed. Holds raw pointers: characters
+ * are expected to remove themselves when they end play.
+ */
+class SCAVENGER_API FScavengerCharacterHash
+{
+public:
+	void SetCellSize(float InCellSize);
+
+	// Inserts Character, or moves it to the cell its location is in now
+	void Update(AScavengerCharacter* Character);
+
+	void Remove(AScavengerCharacter* Character);
+
+	/**
+	 * Living characters within Radius of the segment other than Ignore, the MaxResults closest to it,
+	 * nearest first. Cells visited depend only on the segment's length against the cell size, never on how many
+	 * characters there are; segments are cut off after 16 cells and a Radius wider than a cell counts as one cell.
+	 */
+	void QuerySegment(const FVector& Start, const FVector& End, float Radius, int32 MaxResults, const AActor* Ignore, TArray<AScavengerCharacter*>& OutCharacters) const;
+
+	int32 Num() const { return CellOf.Num(); }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FIntPoint GetCell(const FVector& Location) const;
+
+	float CellSize = 1000.0f;
+
+	TMap<FIntPoint, TArray<AScavengerCharacter*, TInlineAllocator<4>>> Cells;
+	TMap<AScavengerCharacter*, FIntPoint> CellOf;
+};
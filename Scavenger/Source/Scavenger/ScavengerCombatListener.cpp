@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerCombatListener.h"
+
+void AScavengerCombatListener::BeginPlay()
+{
+	Super::BeginPlay();
+
+	BindCombatEvents();
+}
+
+void AScavengerCombatListener::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (CombatEventSource.IsValid()) CombatEventSource->OnCombatEvent.RemoveDynamic(this, &AScavengerCombatListener::OnCombatEvent);
+	CombatEventSource = nullptr;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AScavengerCombatListener::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (!CombatEventSource.IsValid()) BindCombatEvents();
+}
+
+void AScavengerCombatListener::BindCombatEvents()
+{
+	AScavengerGameState* GameState = AScavengerGameState::Get(this);
+	if (!GameState || GameState == CombatEventSource.Get()) return;
+
+	GameState->OnCombatEvent.AddDynamic(this, &AScavengerCombatListener::OnCombatEvent);
+	CombatEventSource = GameState;
+}
+
+void AScavengerCombatListener::OnCombatEvent(const FScavengerCombatEvent& Event)
+{
+	HandleCombatEvent(Event);
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "ScavengerGameState.h"
+#include "ScavengerCombatListener.generated.h"
+
+/**
+ * Base for actors that follow the game state's combat feed. Subscribes as soon as there is a game
+ * state to subscribe to, which on a client can be some frames after this actor spawned, so
+ * subclasses have to tick and call Super::Tick. Events arrive through HandleCombatEvent.
+ */
+UCLASS(Abstract, NotPlaceable, Transient)
+class SCAVENGER_API AScavengerCombatListener : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void HandleCombatEvent(const FScavengerCombatEvent& Event) {}
+
+private:
+	UFUNCTION()
+	void OnCombatEvent(const FScavengerCombatEvent& Event);
+
+	void BindCombatEvents();
+
+	// Game state OnCombatEvent is bound on, unset until it has replicated
+	TWeakObjectPtr<AScavengerGameState> CombatEventSource;
+};
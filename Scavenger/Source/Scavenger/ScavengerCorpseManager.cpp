@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerCorpseManager.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerWorldActor.h"
+
+AScavengerCorpseManager::AScavengerCorpseManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// After physics, so settling is judged on this frame's simulation
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AScavengerCorpseManager* AScavengerCorpseManager::Get(UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_DedicatedServer) return nullptr;
+	return TScavengerWorldActor<AScavengerCorpseManager>::FindOrSpawn(World);
+}
+
+void AScavengerCorpseManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TScavengerWorldActor<AScavengerCorpseManager>::Register(this);
+
+	MaxSimulatingRagdolls = FMath::Max(MaxSimulatingRagdolls, 0);
+	MaxCorpses = FMath::Max(MaxCorpses, 1);
+	Corpses.Reserve(MaxCorpses + 1);
+}
+
+void AScavengerCorpseManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TScavengerWorldActor<AScavengerCorpseManager>::Unregister(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AScavengerCorpseManager::HandleCombatEvent(const FScavengerCombatEvent& Event)
+{
+	if (Event.Type != EScavengerCombatEventType::Kill) return;
+
+	AddCorpse(Cast<AScavengerCharacter>(Event.Victim));
+}
+
+void AScavengerCorpseManager::AddCorpse(AScavengerCharacter* Character)
+{
+	if (!Character) return;
+	for (const FCorpse& Existing : Corpses)
+	{
+		if (Existing.Character.Get() == Character) return;
+	}
+
+	FCorpse Corpse;
+	Corpse.Character = Character;
+	Corpse.DeathTime = GetWorld()->GetTimeSeconds();
+
+	if (RagdollOnDeath && MaxSimulatingRagdolls > 0)
+	{
+		// The newest death is the one being watched, so it gets the physics
+		if (CountRagdolls() >= MaxSimulatingRagdolls)
+		{
+			for (FCorpse& Oldest : Corpses)
+			{
+				if (Oldest.State != ECorpseState::Ragdoll) continue;
+				Freeze(Oldest);
+				break;
+			}
+		}
+		if (StartRagdoll(Character)) Corpse.State = ECorpseState::Ragdoll;
+	}
+
+	Corpses.Add(Corpse);
+
+	while (Corpses.Num() > MaxCorpses)
+	{
+		Recycle(Corpses[0]);
+		Corpses.RemoveAt(0, 1, false);
+	}
+}
+
+void AScavengerCorpseManager::RemoveCorpse(AScavengerCharacter* Character)
+{
+	for (int32 i = 0; i < Corpses.Num(); i++)
+	{
+		if (Corpses[i].Character.Get() != Character) continue;
+		Corpses.RemoveAt(i);
+		return;
+	}
+}
+
+int32 AScavengerCorpseManager::CountRagdolls() const
+{
+	int32 Count = 0;
+	for (const FCorpse& Corpse : Corpses)
+	{
+		if (Corpse.State == ECorpseState::Ragdoll) Count++;
+	}
+	return Count;
+}
+
+bool AScavengerCorpseManager::StartRagdoll(AScavengerCharacter* Character)
+{
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	if (!Mesh || !Mesh->GetPhysicsAsset()) return false;
+
+	// The capsule would hold the body up and keep blocking shots and movement
+	Character->GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Character->GetCharacterMovement()->DisableMovement();
+
+	Mesh->SetCollisionProfileName(RagdollProfile);
+	Mesh->SetAllBodiesSimulatePhysics(true);
+	Mesh->WakeAllRigidBodies();
+	Mesh->bBlendPhysics = true;
+	return true;
+}
+
+void AScavengerCorpseManager::Freeze(FCorpse& Corpse)
+{
+	if (Corpse.State == ECorpseState::Frozen) return;
+	Corpse.State = ECorpseState::Frozen;
+
+	AScavengerCharacter* Character = Corpse.Character.Get();
+	USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	if (!Mesh) return;
+
+	// Keep the last pose on screen and stop both animating and simulating it
+	Mesh->bNoSkeletonUpdate = true;
+	Mesh->SetComponentTickEnabled(false);
+	Mesh->PutAllRigidBodiesToSleep();
+	Mesh->SetAllBodiesSimulatePhysics(false);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Character->GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+void AScavengerCorpseManager::Recycle(FCorpse& Corpse)
+{
+	Freeze(Corpse);
+
+	// Component visibility rather than the actor's, which would replicate from a listen server
+	AScavengerCharacter* Character = Corpse.Character.Get();
+	if (Character && Character->GetMesh()) Character->GetMesh()->SetVisibility(false, true);
+}
+
+void AScavengerCorpseManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float SettleSpeedSq = FMath::Square(SettleSpeed);
+
+	for (int32 i = Corpses.Num() - 1; i >= 0; i--)
+	{
+		FCorpse& Corpse = Corpses[i];
+		AScavengerCharacter* Character = Corpse.Character.Get();
+		if (!Character)
+		{
+			Corpses.RemoveAt(i, 1, false);
+			continue;
+		}
+
+		if (Corpse.State == ECorpseState::Ragdoll)
+		{
+			USkeletalMeshComponent* Mesh = Character->GetMesh();
+			const bool Resting = !Mesh->RigidBodyIsAwake() || Mesh->GetPhysicsLinearVelocity().SizeSquared() < SettleSpeedSq;
+
+			Corpse.SettledFor = Resting ? Corpse.SettledFor + DeltaSeconds : 0.0f;
+			if (Corpse.SettledFor >= SettleDuration || Now - Corpse.DeathTime >= MaxRagdollDuration) Freeze(Corpse);
+		}
+		else if (Corpse.State == ECorpseState::Animated)
+		{
+			if (Now - Corpse.DeathTime >= DeathAnimationDuration) Freeze(Corpse);
+		}
+	}
+}
+
+SIZE_T AScavengerCorpseManager::GetResourceSize(EResourceSizeMode::Type Mode)
+{
+	return Super::GetResourceSize(Mode) + Corpses.GetAllocatedSize();
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ScavengerCombatListener.h"
+#include "ScavengerCorpseManager.generated.h"
+
+class AScavengerCharacter;
+
+/**
+ * Client-side owner of dead bodies. Each death from the combat feed becomes a ragdoll while there
+ * is room under the simulation cap, otherwise the oldest ragdoll is frozen to make room. Bodies that
+ * have settled, or finished their death animation, are frozen into a static pose that costs neither
+ * physics nor animation, and the oldest are hidden once there are more than the corpse limit.
+ * Never exists on dedicated servers, so they don't simulate ragdolls at all.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class SCAVENGER_API AScavengerCorpseManager : public AScavengerCombatListener
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerCorpseManager();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual SIZE_T GetResourceSize(EResourceSizeMode::Type Mode) override;
+
+	// Finds or spawns the manager for World. Always null on dedicated servers.
+	static AScavengerCorpseManager* Get(UWorld* World);
+
+	void AddCorpse(AScavengerCharacter* Character);
+
+	// Stops managing Character's body, for a character brought back to life. The character restores its own mesh.
+	void RemoveCorpse(AScavengerCharacter* Character);
+
+private:
+	enum class ECorpseState : uint8
+	{
+		Ragdoll,
+		Animated,
+		Frozen,
+	};
+
+	struct FCorpse
+	{
+		TWeakObjectPtr<AScavengerCharacter> Character;
+		ECorpseState State = ECorpseState::Animated;
+		float DeathTime = 0.0f;
+		// Seconds the ragdoll has been moving slower than SettleSpeed
+		float SettledFor = 0.0f;
+	};
+
+	virtual void HandleCombatEvent(const FScavengerCombatEvent& Event) override;
+
+	int32 CountRagdolls() const;
+	bool StartRagdoll(AScavengerCharacter* Character);
+	void Freeze(FCorpse& Corpse);
+	void Recycle(FCorpse& Corpse);
+
+	// Ragdolls simulating at once, the oldest is frozen early to make room for a new one
+	UPROPERTY(Config)
+	int32 MaxSimulatingRagdolls = 4;
+
+	// Bodies kept in the world at all, the oldest is hidden beyond this
+	UPROPERTY(Config)
+	int32 MaxCorpses = 12;
+
+	// Off leaves every death to the animation Blueprint
+	UPROPERTY(Config)
+	bool RagdollOnDeath = true;
+
+	UPROPERTY(Config)
+	FName RagdollProfile = TEXT("Ragdoll");
+
+	// A ragdoll whose bodies stay under this speed in cm/s for SettleDuration is frozen
+	UPROPERTY(Config)
+	float SettleSpeed = 5.0f;
+
+	UPROPERTY(Config)
+	float SettleDuration = 0.5f;
+
+	// Ragdolls still moving after this long are frozen regardless
+	UPROPERTY(Config)
+	float MaxRagdollDuration = 6.0f;
+
+	// Seconds the death animation is left to play before an animated body is frozen
+	UPROPERTY(Config)
+	float DeathAnimationDuration = 3.0f;
+
+	// Oldest first
+	TArray<FCorpse> Corpses;
+};
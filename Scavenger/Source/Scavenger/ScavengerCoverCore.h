@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+
+/**
+ * Cover and dash decisions with no engine dependencies: entry and exit angle tests, edge and
+ * pop-out probing, facing selection, the standing/crouched check and dash timing. The world is
+ * reached only through ICoverWorldQuery, so everything here can be compiled and exercised on its
+ * own; Source/Programs/ScavengerCoverCore tests and benchmarks it that way. Angles are compared as
+ * dot products against cosines worked out once up front rather than through acos every tick;
+ * directions passed in are expected to be unit length or zero.
+ */
+namespace ScavengerCover
+{
+	struct FVec3
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	inline FVec3 operator+(const FVec3& A, const FVec3& B) { return FVec3{ A.X + B.X, A.Y + B.Y, A.Z + B.Z }; }
+	inline FVec3 operator*(const FVec3& A, float Scale) { return FVec3{ A.X * Scale, A.Y * Scale, A.Z * Scale }; }
+	inline FVec3 operator-(const FVec3& A) { return FVec3{ -A.X, -A.Y, -A.Z }; }
+	inline float Dot(const FVec3& A, const FVec3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+
+	// What a trace against static geometry found
+	enum class ECoverHit
+	{
+		None,
+		Blocking,
+		Cover,
+	};
+
+	// The only access to the world the core needs, implemented by whoever owns the cover state
+	class ICoverWorldQuery
+	{
+	public:
+		virtual ~ICoverWorldQuery() {}
+
+		// Line trace against static geometry from Start to End
+		virtual ECoverHit TraceStatic(const FVec3& Start, const FVec3& End) const = 0;
+	};
+
+	// Threshold for IsWithinAngle, worked out once when the angle is configured
+	inline float CosFromDegrees(float Degrees)
+	{
+		return std::cos(Degrees * 3.14159265f / 180.0f);
+	}
+
+	// Same as acos(Dot(A, B)) <= the angle CosThreshold came from, for unit A and B
+	inline bool IsWithinAngle(const FVec3& A, const FVec3& B, float CosThreshold)
+	{
+		return Dot(A, B) >= CosThreshold;
+	}
+
+	// Counts a held input towards HoldTime ticks. True on the tick it completes, which starts the count again.
+	inline bool TickHold(bool Held, int& Timer, int HoldTime)
+	{
+		if (!Held) return false;
+		if (++Timer < HoldTime) return false;
+		Timer = 0;
+		return true;
+	}
+
+	// Pushing into the wall the character is stuck to, the way out of cover
+	inline bool IsLeavingCover(const FVec3& Move, const FVec3& CoverDirection, float CosMaxCoverAngle)
+	{
+		return IsWithinAngle(Move, -CoverDirection, CosMaxCoverAngle);
+	}
+
+	// Walking head-on into a cover wall, the way into cover
+	inline bool IsEnteringCover(const FVec3& Move, const FVec3& SurfaceNormal, float CosMaxCoverAngle)
+	{
+		return IsWithinAngle(Move, -SurfaceNormal, CosMaxCoverAngle);
+	}
+
+	// Moving further out past an edge the character has already reached
+	inline bool IsMoveBlockedAtEdge(const FVec3& Move, const FVec3& Right, bool EdgeLeft, bool EdgeRight)
+	{
+		if (EdgeLeft) return Dot(Move, Right) < 0.0f;
+		if (EdgeRight) return Dot(Move, Right) > 0.0f;
+		return false;
+	}
+
+	// Faces whichever way along the wall the input leans
+	inline bool IsFacingRight(const FVec3& Move, const FVec3& Right)
+	{
+		return Dot(Move, Right) > 0.0f;
+	}
+
+	struct FEdgeProbe
+	{
+		ECoverHit Left;
+		ECoverHit Right;
+	};
+
+	// Traces into the wall HalfWidth either side of Location
+	inline FEdgeProbe ProbeEdges(const ICoverWorldQuery& World, const FVec3& Location, const FVec3& Right, const FVec3& CoverDirection, float HalfWidth, float SenseDistance)
+	{
+		const FVec3 Left = Location + Right * -HalfWidth;
+		const FVec3 RightSide = Location + Right * HalfWidth;
+		const FVec3 Reach = CoverDirection * SenseDistance;
+
+		return FEdgeProbe{ World.TraceStatic(Left, Left + Reach), World.TraceStatic(RightSide, RightSide + Reach) };
+	}
+
+	struct FEdgeState
+	{
+		// No cover under that side, the character is held in place
+		bool OnEdgeLeft = false;
+		bool OnEdgeRight = false;
+		// Nothing at all just past that side, close enough to the edge to pop out
+		bool AdjustedLeft = false;
+		bool AdjustedRight = false;
+
+		bool IsOnEdge() const { return OnEdgeLeft || OnEdgeRight; }
+		// Cover has run out on both sides
+		bool IsOffCover() const { return OnEdgeLeft && OnEdgeRight; }
+	};
+
+	// Fills the on-edge half of State from a probe at the character's width
+	inline void ApplyEdgeProbe(const FEdgeProbe& Probe, FEdgeState& State)
+	{
+		State.OnEdgeLeft = Probe.Left != ECoverHit::Cover;
+		State.OnEdgeRight = Probe.Right != ECoverHit::Cover;
+	}
+
+	// Fills the pop-out half of State from a probe a little wider than the character
+	inline void ApplyPopOutProbe(const FEdgeProbe& Probe, FEdgeState& State)
+	{
+		State.AdjustedLeft = Probe.Left == ECoverHit::None;
+		State.AdjustedRight = Probe.Right == ECoverHit::None;
+	}
+
+	// Cover is tall enough to stand behind when something is in front of the head
+	inline bool IsCoverStandable(const ICoverWorldQuery& World, const FVec3& Location, const FVec3& Up, const FVec3& CoverDirection, float HeadHeight, float SenseDistance)
+	{
+		const FVec3 Head = Location + Up * HeadHeight;
+		return World.TraceStatic(Head, Head + CoverDirection * SenseDistance) != ECoverHit::None;
+	}
+
+	// Dash timing in ticks
+	inline bool IsDashReady(int CooldownTimer, int Cooldown)
+	{
+		return CooldownTimer >= Cooldown;
+	}
+
+	// Advances a running dash. True once it has lasted Duration ticks.
+	inline bool TickDash(int& Timer, int Duration)
+	{
+		return ++Timer >= Duration;
+	}
+
+	// Advances the cooldown while no dash is running
+	inline void TickDashCooldown(int& CooldownTimer, int Cooldown)
+	{
+		if (CooldownTimer < Cooldown) CooldownTimer++;
+	}
+}
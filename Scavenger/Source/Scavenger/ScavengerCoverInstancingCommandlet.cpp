@@ -0,0 +1,241 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerCoverInstancingCommandlet.h"
+#include "CollidableCoverComponent.h"
+#include "GameMapsSettings.h"
+#include "EngineUtils.h"
+#include "StaticMeshResources.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+
+namespace ScavengerCoverInstancing
+{
+	static const FName CoverTag(TEXT("Cover"));
+
+	struct FMeshCounts
+	{
+		int32 Components = 0;
+		int32 DrawCalls = 0;
+		int32 CoverComponents = 0;
+		int32 CoverDrawCalls = 0;
+	};
+
+	static int32 CountSections(const UStaticMesh* Mesh)
+	{
+		if (!Mesh || !Mesh->RenderData || Mesh->RenderData->LODResources.Num() == 0) return 0;
+		return Mesh->RenderData->LODResources[0].Sections.Num();
+	}
+
+	// Static mesh components in the persistent level and the draws they cost at LOD 0. An instanced
+	// component is counted as one draw per section, a lower bound as clusters can be drawn separately.
+	static FMeshCounts CountStaticMeshes(UWorld* World)
+	{
+		FMeshCounts Counts;
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			if (It->GetLevel() != World->PersistentLevel) continue;
+
+			TInlineComponentArray<UStaticMeshComponent*> Components;
+			It->GetComponents(Components);
+			for (UStaticMeshComponent* Component : Components)
+			{
+				const UInstancedStaticMeshComponent* Instanced = Cast<UInstancedStaticMeshComponent>(Component);
+				const int32 DrawCalls = Instanced && Instanced->GetInstanceCount() == 0 ? 0 : CountSections(Component->StaticMesh);
+
+				Counts.Components++;
+				Counts.DrawCalls += DrawCalls;
+				if (Component->ComponentHasTag(CoverTag))
+				{
+					Counts.CoverComponents++;
+					Counts.CoverDrawCalls += DrawCalls;
+				}
+			}
+		}
+		return Counts;
+	}
+
+	// Plain cover props only: anything with actor tags, attachments or extra components may be
+	// looked up or driven by something else and has to stay an actor
+	static bool IsMergeable(AStaticMeshActor* Actor)
+	{
+		UStaticMeshComponent* Mesh = Actor->GetStaticMeshComponent();
+		if (!Mesh || !Mesh->StaticMesh || !Mesh->ComponentHasTag(CoverTag)) return false;
+		if (Mesh->Mobility != EComponentMobility::Static || Actor->Tags.Num() > 0) return false;
+		if (Actor->GetAttachParentActor()) return false;
+
+		TArray<AActor*> Attached;
+		Actor->GetAttachedActors(Attached);
+		if (Attached.Num() > 0) return false;
+
+		TInlineComponentArray<UActorComponent*> Components;
+		Actor->GetComponents(Components);
+		for (UActorComponent* Component : Components)
+		{
+			if (Component != Mesh && !Component->IsA<UCollidableCoverComponent>()) return false;
+		}
+		return true;
+	}
+
+	// Props can share an instanced component only if they look and collide the same
+	static FString GetGroupKey(UStaticMeshComponent* Mesh)
+	{
+		FString Key = Mesh->StaticMesh->GetPathName();
+		for (int32 i = 0; i < Mesh->GetNumMaterials(); i++) Key += TEXT("|") + GetPathNameSafe(Mesh->GetMaterial(i));
+
+		Key += FString::Printf(TEXT("|%s|%d|%d|%d|"), *Mesh->GetCollisionProfileName().ToString(),
+			(int32)Mesh->GetCollisionEnabled(), (int32)Mesh->GetCollisionObjectType(), Mesh->CastShadow ? 1 : 0);
+		for (int32 Channel = 0; Channel < ECC_MAX; Channel++)
+		{
+			Key.AppendChar(TEXT('0') + (TCHAR)Mesh->GetCollisionResponseToChannel((ECollisionChannel)Channel));
+		}
+
+		TArray<FString> Tags;
+		for (const FName& Tag : Mesh->ComponentTags) Tags.Add(Tag.ToString());
+		Tags.Sort();
+		for (const FString& Tag : Tags) Key += TEXT("|") + Tag;
+
+		return Key;
+	}
+
+	static void Merge(UWorld* World, const TArray<AStaticMeshActor*>& Group)
+	{
+		UStaticMeshComponent* Source = Group[0]->GetStaticMeshComponent();
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.OverrideLevel = World->PersistentLevel;
+		SpawnParams.Name = MakeUniqueObjectName(World->PersistentLevel, AActor::StaticClass(), FName(*FString::Printf(TEXT("CoverInstances_%s"), *Source->StaticMesh->GetName())));
+		AActor* Merged = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+
+		// At the origin, so instance transforms are the props' world transforms
+		UHierarchicalInstancedStaticMeshComponent* Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(Merged, TEXT("CoverInstances"));
+		Instances->SetMobility(EComponentMobility::Static);
+		Instances->SetStaticMesh(Source->StaticMesh);
+		Instances->OverrideMaterials = Source->OverrideMaterials;
+		Instances->BodyInstance.CopyBodyInstancePropertiesFrom(&Source->BodyInstance);
+		Instances->CastShadow = Source->CastShadow;
+		// The Cover tag is what cover traces and OnHit look for, on whichever instance they hit
+		Instances->ComponentTags = Source->ComponentTags;
+
+		Merged->SetRootComponent(Instances);
+		Merged->AddInstanceComponent(Instances);
+
+		bool HasCoverComponent = false;
+		for (AStaticMeshActor* Actor : Group)
+		{
+			Instances->AddInstance(Actor->GetActorTransform());
+			HasCoverComponent |= Actor->FindComponentByClass<UCollidableCoverComponent>() != nullptr;
+		}
+
+		if (HasCoverComponent)
+		{
+			UCollidableCoverComponent* Cover = NewObject<UCollidableCoverComponent>(Merged, TEXT("CollidableCover"));
+			Merged->AddInstanceComponent(Cover);
+			Cover->RegisterComponent();
+		}
+
+		Instances->RegisterComponent();
+		Instances->BuildTree();
+
+#if WITH_EDITOR
+		Merged->SetActorLabel(Merged->GetName());
+#endif
+
+		for (AStaticMeshActor* Actor : Group) Actor->Destroy();
+	}
+}
+
+using namespace ScavengerCoverInstancing;
+
+UScavengerCoverInstancingCommandlet::UScavengerCoverInstancingCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UScavengerCoverInstancingCommandlet::Main(const FString& Params)
+{
+	FString MapName = GetDefault<UGameMapsSettings>()->GetGameDefaultMap();
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	// Loading and saving want the package, not the object path the setting holds
+	MapName = FPackageName::ObjectPathToPackageName(MapName);
+
+	FParse::Value(*Params, TEXT("MinInstances="), MinInstances);
+	MinInstances = FMath::Max(MinInstances, 2);
+
+	const bool DryRun = FParse::Param(*Params, TEXT("DryRun"));
+
+	UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Map %s not found"), *MapName);
+		return 2;
+	}
+
+	// An editor world, initialized far enough for components to register and actors to be spawned
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues IVS;
+		IVS.RequiresHitProxies(false);
+		IVS.ShouldSimulatePhysics(false);
+		IVS.EnableTraceCollision(false);
+		IVS.CreateNavigation(false);
+		IVS.CreateAISystem(false);
+		IVS.AllowAudioPlayback(false);
+		IVS.CreatePhysicsScene(true);
+		World->InitWorld(IVS);
+		World->PersistentLevel->UpdateModelComponents();
+		World->UpdateWorldComponents(true, false);
+	}
+
+	const FMeshCounts Before = CountStaticMeshes(World);
+
+	TMap<FString, TArray<AStaticMeshActor*>> Groups;
+	int32 Ineligible = 0;
+	for (TActorIterator<AStaticMeshActor> It(World); It; ++It)
+	{
+		if (It->GetLevel() != World->PersistentLevel) continue;
+
+		UStaticMeshComponent* Mesh = It->GetStaticMeshComponent();
+		if (!Mesh || !Mesh->ComponentHasTag(CoverTag)) continue;
+
+		if (IsMergeable(*It)) Groups.FindOrAdd(GetGroupKey(Mesh)).Add(*It);
+		else Ineligible++;
+	}
+
+	int32 MergedGroups = 0;
+	int32 MergedProps = 0;
+	for (const auto& Group : Groups)
+	{
+		if (Group.Value.Num() < MinInstances) continue;
+
+		UE_LOG(LogScavenger, Display, TEXT("  %4d x %s"), Group.Value.Num(), *Group.Value[0]->GetStaticMeshComponent()->StaticMesh->GetPathName());
+		Merge(World, Group.Value);
+		MergedGroups++;
+		MergedProps += Group.Value.Num();
+	}
+
+	const FMeshCounts After = CountStaticMeshes(World);
+
+	UE_LOG(LogScavenger, Display, TEXT("Merged %d cover props into %d instanced components, %d left as actors (%d not eligible)"),
+		MergedProps, MergedGroups, Before.CoverComponents - MergedProps, Ineligible);
+	UE_LOG(LogScavenger, Display, TEXT("Cover components: %d -> %d, draw calls: %d -> %d"), Before.CoverComponents, After.CoverComponents, Before.CoverDrawCalls, After.CoverDrawCalls);
+	UE_LOG(LogScavenger, Display, TEXT("All static mesh components: %d -> %d, draw calls: %d -> %d"), Before.Components, After.Components, Before.DrawCalls, After.DrawCalls);
+
+	if (DryRun || MergedGroups == 0) return 0;
+
+	const FString Filename = FPackageName::LongPackageNameToFilename(MapName, FPackageName::GetMapPackageExtension());
+	if (!UPackage::SavePackage(Package, World, RF_NoFlags, *Filename, GError, nullptr, false, true, SAVE_NoError))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Couldn't save %s"), *Filename);
+		return 1;
+	}
+
+	UE_LOG(LogScavenger, Display, TEXT("Saved %s, rebuild lighting before shipping it"), *Filename);
+	return 0;
+}
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ScavengerCoverInstancingCommandlet.generated.h"
+
+/**
+ * Merges repeated cover props in a map into hierarchical instanced static mesh components.
+ * Static mesh actors whose mesh component carries the Cover tag are grouped by mesh, materials,
+ * collision and tags; each group large enough is replaced by one actor holding an instanced component
+ * with the same collision settings and component tags, so cover traces and OnHit see the Cover tag on
+ * whatever instance they hit exactly as before. Actors with actor tags, attachments or components
+ * beyond the mesh and a UCollidableCoverComponent are left alone, since something may look them up.
+ * Component and draw call counts are reported before and after; the map is saved unless -DryRun.
+ * Static lighting needs rebuilding afterwards.
+ *
+ * UE4Editor-Cmd Scavenger -run=ScavengerCoverInstancing [-Map=/Game/Default_Test] [-MinInstances=4] [-DryRun]
+ */
+UCLASS(Config = Game)
+class UScavengerCoverInstancingCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UScavengerCoverInstancingCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// Groups smaller than this are left as separate actors
+	UPROPERTY(Config)
+	int32 MinInstances = 4;
+};
@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerEffectManager.h"
+#include "ScavengerWorldActor.h"
+#include "Components/DecalComponent.h"
+
+AScavengerEffectManager::AScavengerEffectManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// After cameras have moved, so culling uses this frame's view
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AScavengerEffectManager* AScavengerEffectManager::Get(UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_DedicatedServer) return nullptr;
+	return TScavengerWorldActor<AScavengerEffectManager>::FindOrSpawn(World);
+}
+
+void AScavengerEffectManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TScavengerWorldActor<AScavengerEffectManager>::Register(this);
+
+	// Build every pool up front so a firefight never creates components
+	Pools.SetNum(EffectTypes.Num());
+	for (int32 TypeIndex = 0; TypeIndex < EffectTypes.Num(); TypeIndex++)
+	{
+		const FScavengerEffectType& Type = EffectTypes[TypeIndex];
+		FEffectPool& Pool = Pools[TypeIndex];
+
+		Pool.Template = Cast<UParticleSystem>(Type.Particle.TryLoad());
+		Pool.DecalMaterial = Cast<UMaterialInterface>(Type.DecalMaterial.TryLoad());
+		if (Pool.Template) PooledObjects.Add(Pool.Template);
+		if (Pool.DecalMaterial) PooledObjects.Add(Pool.DecalMaterial);
+
+		for (int32 i = 0; i < Type.PoolSize; i++)
+		{
+			if (Pool.Template)
+			{
+				UParticleSystemComponent* Particle = NewObject<UParticleSystemComponent>(this);
+				Particle->bAutoActivate = false;
+				Particle->bAutoDestroy = false;
+				Particle->SetTemplate(Pool.Template);
+				Particle->RegisterComponent();
+				Pool.Particles.Add(Particle);
+				PooledObjects.Add(Particle);
+			}
+
+			if (Pool.DecalMaterial)
+			{
+				UDecalComponent* Decal = NewObject<UDecalComponent>(this);
+				Decal->SetDecalMaterial(Pool.DecalMaterial);
+				Decal->DecalSize = Type.DecalSize;
+				Decal->SetVisibility(false);
+				Decal->RegisterComponent();
+				Pool.Decals.Add(Decal);
+				Pool.DecalExpireTimes.Add(0.0f);
+				PooledObjects.Add(Decal);
+			}
+		}
+	}
+}
+
+void AScavengerEffectManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TScavengerWorldActor<AScavengerEffectManager>::Unregister(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AScavengerEffectManager::HandleCombatEvent(const FScavengerCombatEvent& Event)
+{
+	switch (Event.Type)
+	{
+	case EScavengerCombatEventType::Hit:
+		RequestEffect(TEXT("Hit"), Event.Location, Event.Normal.Rotation());
+		break;
+	case EScavengerCombatEventType::Impact:
+		RequestEffect(TEXT("Impact"), Event.Location, Event.Normal.Rotation());
+		break;
+	default:
+		break;
+	}
+}
+
+void AScavengerEffectManager::RequestEffect(FName Type, const FVector& Location, const FRotator& Rotation)
+{
+	const int32 TypeIndex = EffectTypes.IndexOfByPredicate([&](const FScavengerEffectType& Entry) { return Entry.Name == Type; });
+	if (TypeIndex == INDEX_NONE) return;
+
+	// Pellets and rapid fire land in the same spot many times a frame, one effect covers them all
+	const float MergeDistanceSq = FMath::Square(MergeDistance);
+	for (const FEffectRequest& Pending : PendingRequests)
+	{
+		if (Pending.TypeIndex == TypeIndex && FVector::DistSquared(Pending.Location, Location) < MergeDistanceSq) return;
+	}
+
+	FEffectRequest Request;
+	Request.TypeIndex = TypeIndex;
+	Request.Location = Location;
+	Request.Rotation = Rotation;
+	PendingRequests.Add(Request);
+}
+
+void AScavengerEffectManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	ExpireDecals();
+
+	if (PendingRequests.Num() == 0) return;
+
+	FVector ViewLocation;
+	FVector ViewDirection;
+	float CosHalfFOV;
+	const bool HaveView = GetViewPoint(ViewLocation, ViewDirection, CosHalfFOV);
+
+	int32 LiveParticles = CountLiveParticles();
+	int32 Spawned = 0;
+
+	for (const FEffectRequest& Request : PendingRequests)
+	{
+		if (Spawned >= SpawnBudgetPerFrame) break;
+
+		const FScavengerEffectType& Type = EffectTypes[Request.TypeIndex];
+
+		if (HaveView)
+		{
+			const FVector ToEffect = Request.Location - ViewLocation;
+			const float DistanceSq = ToEffect.SizeSquared();
+			if (DistanceSq > FMath::Square(Type.CullDistance)) continue;
+
+			// Outside the view cone; anything right next to the camera is kept regardless
+			if (DistanceSq > FMath::Square(200.0f) && FVector::DotProduct(ToEffect.GetUnsafeNormal(), ViewDirection) < CosHalfFOV) continue;
+		}
+
+		// Restarting a system that is still playing doesn't add to the live count
+		FEffectPool& Pool = Pools[Request.TypeIndex];
+		const bool AddsLiveParticle = Pool.Particles.Num() > 0 && !Pool.Particles[Pool.NextParticle]->IsActive();
+		if (AddsLiveParticle && LiveParticles >= MaxLiveParticles) continue;
+
+		SpawnFromPool(Pool, Type, Request);
+		Spawned++;
+		if (AddsLiveParticle) LiveParticles++;
+	}
+
+	PendingRequests.Reset();
+}
+
+void AScavengerEffectManager::SpawnFromPool(FEffectPool& Pool, const FScavengerEffectType& Type, const FEffectRequest& Request)
+{
+	if (Pool.Particles.Num() > 0)
+	{
+		// Round robin, so a busy pool restarts its oldest system
+		UParticleSystemComponent* Particle = Pool.Particles[Pool.NextParticle];
+		Pool.NextParticle = (Pool.NextParticle + 1) % Pool.Particles.Num();
+
+		Particle->SetWorldLocationAndRotation(Request.Location, Request.Rotation);
+		Particle->ActivateSystem(true);
+	}
+
+	if (Pool.Decals.Num() > 0)
+	{
+		const int32 DecalIndex = Pool.NextDecal;
+		Pool.NextDecal = (Pool.NextDecal + 1) % Pool.Decals.Num();
+
+		UDecalComponent* Decal = Pool.Decals[DecalIndex];
+		// Decals project along their X axis, so face them into the surface
+		Decal->SetWorldLocationAndRotation(Request.Location, (-Request.Rotation.Vector()).Rotation());
+		Decal->SetVisibility(true);
+		Pool.DecalExpireTimes[DecalIndex] = GetWorld()->GetTimeSeconds() + Type.DecalLifetime;
+	}
+}
+
+void AScavengerEffectManager::ExpireDecals()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (FEffectPool& Pool : Pools)
+	{
+		for (int32 i = 0; i < Pool.Decals.Num(); i++)
+		{
+			if (Pool.DecalExpireTimes[i] > 0.0f && Pool.DecalExpireTimes[i] <= Now)
+			{
+				Pool.Decals[i]->SetVisibility(false);
+				Pool.DecalExpireTimes[i] = 0.0f;
+			}
+		}
+	}
+}
+
+int32 AScavengerEffectManager::CountLiveParticles() const
+{
+	int32 Live = 0;
+	for (const FEffectPool& Pool : Pools)
+	{
+		for (const UParticleSystemComponent* Particle : Pool.Particles)
+		{
+			if (Particle->IsActive()) Live++;
+		}
+	}
+	return Live;
+}
+
+bool AScavengerEffectManager::GetViewPoint(FVector& OutLocation, FVector& OutDirection, float& OutCosHalfFOV) const
+{
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (!PC || !PC->PlayerCameraManager) return false;
+
+	FRotator ViewRotation;
+	PC->GetPlayerViewPoint(OutLocation, ViewRotation);
+	OutDirection = ViewRotation.Vector();
+
+	// Horizontal FOV plus a margin, wide screens see further to the side than this but not by much
+	const float HalfFOV = FMath::DegreesToRadians(PC->PlayerCameraManager->GetFOVAngle() * 0.5f + 15.0f);
+	OutCosHalfFOV = FMath::Cos(FMath::Min(HalfFOV, PI * 0.5f));
+	return true;
+}
+
+SIZE_T AScavengerEffectManager::GetResourceSize(EResourceSizeMode::Type Mode)
+{
+	// Pooled components are counted as components, this is only the bookkeeping around them
+	SIZE_T Size = Super::GetResourceSize(Mode) + Pools.GetAllocatedSize() + PendingRequests.GetAllocatedSize();
+	for (const FEffectPool& Pool : Pools)
+	{
+		Size += Pool.Particles.GetAllocatedSize() + Pool.Decals.GetAllocatedSize() + Pool.DecalExpireTimes.GetAllocatedSize();
+	}
+	return Size;
+}
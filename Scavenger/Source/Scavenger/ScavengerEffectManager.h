@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ScavengerCombatListener.h"
+#include "ScavengerEffectManager.generated.h"
+
+// Content and limits for one kind of cosmetic effect
+USTRUCT()
+struct FScavengerEffectType
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(Config)
+	FName Name;
+
+	UPROPERTY(Config)
+	FStringAssetReference Particle;
+
+	UPROPERTY(Config)
+	FStringAssetReference DecalMaterial;
+
+	UPROPERTY(Config)
+	FVector DecalSize = FVector(8.0f, 16.0f, 16.0f);
+
+	// Seconds a decal stays up before its pooled component is hidden again
+	UPROPERTY(Config)
+	float DecalLifetime = 10.0f;
+
+	// Particle and decal components kept for this type, the oldest is reused when all are busy
+	UPROPERTY(Config)
+	int32 PoolSize = 16;
+
+	// Requests further than this from the local view are dropped
+	UPROPERTY(Config)
+	float CullDistance = 4000.0f;
+};
+
+/**
+ * Client-side owner of impact, hit and muzzle effects. Particle and decal components are pooled per
+ * effect type; requests queue up over the frame and are spawned together in Tick under a per-frame
+ * spawn budget and a global live-instance cap, after culling anything off-screen or too far away.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class SCAVENGER_API AScavengerEffectManager : public AScavengerCombatListener
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerEffectManager();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual SIZE_T GetResourceSize(EResourceSizeMode::Type Mode) override;
+
+	// Finds or spawns the manager for World. Always null on dedicated servers.
+	static AScavengerEffectManager* Get(UWorld* World);
+
+	// Queues an effect for this frame's batch
+	void RequestEffect(FName Type, const FVector& Location, const FRotator& Rotation);
+
+private:
+	struct FEffectRequest
+	{
+		int32 TypeIndex;
+		FVector Location;
+		FRotator Rotation;
+	};
+
+	struct FEffectPool
+	{
+		UParticleSystem* Template = nullptr;
+		UMaterialInterface* DecalMaterial = nullptr;
+		TArray<UParticleSystemComponent*> Particles;
+		TArray<UDecalComponent*> Decals;
+		TArray<float> DecalExpireTimes;
+		int32 NextParticle = 0;
+		int32 NextDecal = 0;
+	};
+
+	virtual void HandleCombatEvent(const FScavengerCombatEvent& Event) override;
+
+	bool GetViewPoint(FVector& OutLocation, FVector& OutDirection, float& OutCosHalfFOV) const;
+	int32 CountLiveParticles() const;
+	void SpawnFromPool(FEffectPool& Pool, const FScavengerEffectType& Type, const FEffectRequest& Request);
+	void ExpireDecals();
+
+	UPROPERTY(Config)
+	TArray<FScavengerEffectType> EffectTypes;
+
+	// Most effects started in a single frame, the rest of the frame's requests are dropped
+	UPROPERTY(Config)
+	int32 SpawnBudgetPerFrame = 8;
+
+	// Most particle systems alive at once across every type
+	UPROPERTY(Config)
+	int32 MaxLiveParticles = 48;
+
+	// Requests of the same type closer than this within a frame collapse into one
+	UPROPERTY(Config)
+	float MergeDistance = 20.0f;
+
+	TArray<FEffectPool> Pools;
+	TArray<FEffectRequest> PendingRequests;
+
+	// Keeps every pooled component and loaded asset referenced
+	UPROPERTY(Transient)
+	TArray<UObject*> PooledObjects;
+};
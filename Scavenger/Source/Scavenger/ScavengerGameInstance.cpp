@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerGameInstance.h"
+#include "ScavengerMetrics.h"
+#include "ScavengerMemory.h"
+#include "ScavengerLoadingScreen.h"
+#include "GameMapsSettings.h"
+#include "MoviePlayer.h"
+
+UScavengerGameInstance::UScavengerGameInstance()
+{
+	DefaultPawnClassRef = FStringClassReference(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C"));
+}
+
+UScavengerGameInstance* UScavengerGameInstance::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, false) : nullptr;
+	return World ? Cast<UScavengerGameInstance>(World->GetGameInstance()) : nullptr;
+}
+
+void UScavengerGameInstance::Init()
+{
+	Super::Init();
+
+	// Engine start time, so the first report covers the whole boot and not just our part of it
+	BootStartTime = GStartTime;
+	MapLoadStartTime = FPlatformTime::Seconds();
+
+	FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UScavengerGameInstance::OnPreLoadMap);
+	FCoreUObjectDelegates::PostLoadMap.AddUObject(this, &UScavengerGameInstance::OnPostLoadMap);
+
+	ShowLoadingScreen();
+
+	// The default map is loaded straight after Init, get its content moving before that starts
+	PreloadForMap(UGameMapsSettings::GetGameDefaultMap());
+
+	// Dedicated servers only, nothing else is watched by a scraper
+	FParse::Value(FCommandLine::Get(), TEXT("MetricsPort="), MetricsPort);
+	if (IsRunningDedicatedServer() && MetricsPort > 0)
+	{
+		Metrics = MakeShareable(new FScavengerMetrics(this));
+		if (!Metrics->Start(MetricsBindAddress, MetricsPort, MetricsPublishInterval)) Metrics.Reset();
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("MemoryCsvInterval="), MemoryCsvInterval);
+	if (MemoryCsvInterval > 0.0f)
+	{
+		MemoryCsv = MakeShareable(new FScavengerMemoryCsv(this));
+		if (!MemoryCsv->Start(MemoryCsvInterval)) MemoryCsv.Reset();
+	}
+}
+
+void UScavengerGameInstance::Shutdown()
+{
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMap.RemoveAll(this);
+
+	Metrics.Reset();
+	MemoryCsv.Reset();
+
+	Super::Shutdown();
+}
+
+void UScavengerGameInstance::PreloadForMap(const FString& MapName)
+{
+	FString LongMapName = MapName;
+	int32 DotIndex;
+	if (LongMapName.FindChar(TEXT('.'), DotIndex)) LongMapName = LongMapName.Left(DotIndex);
+
+	if (LongMapName.IsEmpty() || LongMapName == PreloadingMap) return;
+
+	PreloadingMap = LongMapName;
+	PreloadStartTime = FPlatformTime::Seconds();
+
+	// Gather the manifest: the pawn every map needs, plus whatever the map lists for itself
+	TArray<FStringAssetReference> Requested;
+	if (DefaultPawnClassRef.IsValid()) Requested.AddUnique(DefaultPawnClassRef);
+
+	const FString ShortMapName = FPackageName::GetShortName(LongMapName);
+	for (const FScavengerPreloadManifest& Manifest : PreloadManifests)
+	{
+		if (Manifest.Map.Equals(LongMapName, ESearchCase::IgnoreCase) || Manifest.Map.Equals(ShortMapName, ESearchCase::IgnoreCase))
+		{
+			for (const FStringAssetReference& Asset : Manifest.Assets)
+			{
+				if (Asset.IsValid()) Requested.AddUnique(Asset);
+			}
+			if (IsRunningDedicatedServer()) continue;
+			for (const FStringAssetReference& Asset : Manifest.ClientAssets)
+			{
+				if (Asset.IsValid()) Requested.AddUnique(Asset);
+			}
+		}
+	}
+
+	// Release the previous map's requests, finished or not, so its handles don't outlive the travel.
+	// Anything this map shares with it is re-pinned when this request lands.
+	for (const FStringAssetReference& Asset : PreloadRequested)
+	{
+		if (!Requested.Contains(Asset)) StreamableManager.Unload(Asset);
+	}
+	PreloadedAssets.Reset();
+	PreloadRequested = Requested;
+
+	// A callback from a request made before this one is ignored when it lands
+	PreloadSerial++;
+	bPreloadPending = true;
+	UE_LOG(LogScavenger, Log, TEXT("Preloading %d assets for %s"), Requested.Num(), *LongMapName);
+
+	StreamableManager.RequestAsyncLoad(Requested,
+		FStreamableDelegate::CreateUObject(this, &UScavengerGameInstance::OnManifestLoaded, PreloadSerial, LongMapName, Requested));
+}
+
+void UScavengerGameInstance::OnManifestLoaded(int32 Serial, FString MapName, TArray<FStringAssetReference> Requested)
+{
+	if (Serial != PreloadSerial) return;
+	bPreloadPending = false;
+
+	int32 Loaded = 0;
+	for (const FStringAssetReference& Asset : Requested)
+	{
+		UObject* Object = Asset.ResolveObject();
+		if (Object)
+		{
+			PreloadedAssets.AddUnique(Object);
+			Loaded++;
+		}
+		else
+		{
+			UE_LOG(LogScavenger, Warning, TEXT("Preload of %s for %s failed"), *Asset.ToString(), *MapName);
+		}
+	}
+
+	UE_LOG(LogScavenger, Log, TEXT("Preloaded %d/%d assets for %s in %.2fs"),
+		Loaded, Requested.Num(), *MapName, FPlatformTime::Seconds() - PreloadStartTime);
+}
+
+UClass* UScavengerGameInstance::ResolveDefaultPawnClass()
+{
+	if (!DefaultPawnClassRef.IsValid()) return nullptr;
+
+	UClass* PawnClass = Cast<UClass>(DefaultPawnClassRef.ResolveObject());
+	if (!PawnClass)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Pawn class %s not preloaded, loading synchronously"), *DefaultPawnClassRef.ToString());
+		PawnClass = Cast<UClass>(StreamableManager.SynchronousLoad(DefaultPawnClassRef));
+	}
+	return PawnClass;
+}
+
+void UScavengerGameInstance::NotifyFirstPlayableFrame()
+{
+	if (bReportedFirstFrame) return;
+	bReportedFirstFrame = true;
+
+	const double Now = FPlatformTime::Seconds();
+	if (!bFirstMapLoaded)
+	{
+		UE_LOG(LogScavenger, Log, TEXT("Time to first playable frame: %.2fs since boot"), Now - BootStartTime);
+	}
+	else
+	{
+		UE_LOG(LogScavenger, Log, TEXT("Time to first playable frame: %.2fs since map load started"), Now - MapLoadStartTime);
+	}
+
+	// What each server instance costs, the number that decides how many fit on a host
+	if (IsRunningDedicatedServer())
+	{
+		const FPlatformMemoryStats Stats = FPlatformMemory::GetStats();
+		UE_LOG(LogScavenger, Log, TEXT("Server ready: resident %.1f MB, peak %.1f MB, virtual %.1f MB"),
+			Stats.UsedPhysical / 1048576.0, Stats.PeakUsedPhysical / 1048576.0, Stats.UsedVirtual / 1048576.0);
+	}
+	bFirstMapLoaded = true;
+}
+
+FString UScavengerGameInstance::GetTravelMapName() const
+{
+	const FWorldContext* Context = GetWorldContext();
+	if (!Context) return FString();
+
+	if (Context->PendingNetGame) return Context->PendingNetGame->URL.Map;
+	if (!Context->TravelURL.IsEmpty()) return FURL(nullptr, *Context->TravelURL, TRAVEL_Absolute).Map;
+	return FString();
+}
+
+void UScavengerGameInstance::OnPreLoadMap()
+{
+	MapLoadStartTime = FPlatformTime::Seconds();
+	bReportedFirstFrame = false;
+
+	// Usually already requested by the game mode before travelling, this catches clients following the server
+	PreloadForMap(GetTravelMapName());
+}
+
+void UScavengerGameInstance::OnPostLoadMap()
+{
+	UE_LOG(LogScavenger, Log, TEXT("Map load finished in %.2fs, preload %s"),
+		FPlatformTime::Seconds() - MapLoadStartTime, IsPreloadComplete() ? TEXT("complete") : TEXT("still streaming"));
+
+	// The movie player forgets its attributes once a load finishes, arm it again for the next one
+	ShowLoadingScreen();
+}
+
+void UScavengerGameInstance::ShowLoadingScreen()
+{
+	if (!bShowLoadingScreen || IsRunningDedicatedServer()) return;
+
+	// Picked up by the movie player on the next PreLoadMap; it keeps drawing on its own thread
+	// while the game thread is stuck in LoadMap
+	FLoadingScreenAttributes LoadingScreen;
+	LoadingScreen.bAutoCompleteWhenLoadingCompletes = true;
+	LoadingScreen.WidgetLoadingScreen = SNew(SScavengerLoadingScreen)
+		.Message(NSLOCTEXT("Scavenger", "LoadingScreenMessage", "Loading"));
+	GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+#include "ScavengerGameInstance.generated.h"
+
+class FScavengerMetrics;
+class FScavengerMemoryCsv;
+
+// List of assets to stream in before a given map is playable
+USTRUCT()
+struct FScavengerPreloadManifest
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Long package name of the map, e.g. /Game/Default_Test
+	UPROPERTY(Config)
+	FString Map;
+
+	// Pawn, weapon, animation and cover assets the map needs on its first frame.
+	// Hard dependencies of each entry (meshes, anim blueprints) stream in with it.
+	UPROPERTY(Config)
+	TArray<FStringAssetReference> Assets;
+
+	// HUD and other presentation-only assets, never loaded by a dedicated server
+	UPROPERTY(Config)
+	TArray<FStringAssetReference> ClientAssets;
+};
+
+/**
+ * Owns the streamable manager for the game and preloads each map's asset manifest
+ * asynchronously, so boot and map changes don't block on synchronous content loads.
+ */
+UCLASS(Config = Game)
+class SCAVENGER_API UScavengerGameInstance : public UGameInstance
+{
+	GENERATED_BODY()
+
+public:
+	UScavengerGameInstance();
+
+	virtual void Init() override;
+	virtual void Shutdown() override;
+
+	// Starts streaming everything listed for MapName. Safe to call more than once per map.
+	void PreloadForMap(const FString& MapName);
+
+	// True once every asset requested for the current map is resident
+	bool IsPreloadComplete() const { return !bPreloadPending; }
+
+	// True if the current map's preload asked for Asset, which must then stay loaded
+	bool IsPreloadAsset(const FStringAssetReference& Asset) const { return PreloadRequested.Contains(Asset); }
+
+	// Called by the first locally controlled pawn to tick (or the server once the match is ready),
+	// logs time-to-first-playable-frame for the current map, and resident memory on a dedicated server
+	void NotifyFirstPlayableFrame();
+
+	// Resolves the configured pawn class, synchronously only if the preload hasn't brought it in yet
+	UClass* ResolveDefaultPawnClass();
+
+	// Shared loader for soft references used by gameplay code
+	FStreamableManager StreamableManager;
+
+	static UScavengerGameInstance* Get(const UObject* WorldContextObject);
+
+private:
+	void OnPreLoadMap();
+	void OnPostLoadMap();
+
+	void OnManifestLoaded(int32 Serial, FString MapName, TArray<FStringAssetReference> Requested);
+
+	void ShowLoadingScreen();
+
+	FString GetTravelMapName() const;
+
+	// Per-map manifests, keyed by long package name
+	UPROPERTY(Config)
+	TArray<FScavengerPreloadManifest> PreloadManifests;
+
+	// Pawn class preloaded for every map, replaces the hard constructor lookup in the game mode
+	UPROPERTY(Config)
+	FStringClassReference DefaultPawnClassRef;
+
+	// Show a loading screen while maps load (ignored on dedicated servers)
+	UPROPERTY(Config)
+	bool bShowLoadingScreen = true;
+
+	// Port dedicated servers serve Prometheus metrics on, 0 turns the endpoint off. -MetricsPort= overrides.
+	UPROPERTY(Config)
+	int32 MetricsPort = 0;
+
+	// Keep to loopback unless a scraper elsewhere genuinely needs it
+	UPROPERTY(Config)
+	FString MetricsBindAddress = TEXT("127.0.0.1");
+
+	// Seconds between refreshes of the metrics page
+	UPROPERTY(Config)
+	float MetricsPublishInterval = 1.0f;
+
+	TSharedPtr<FScavengerMetrics> Metrics;
+
+	// Seconds between rows of the memory CSV in Saved/Profiling, at least 1, 0 writes none. -MemoryCsvInterval= overrides.
+	UPROPERTY(Config)
+	float MemoryCsvInterval = 0.0f;
+
+	TSharedPtr<FScavengerMemoryCsv> MemoryCsv;
+
+	// Hard references to the preloaded assets so they aren't collected before the map uses them
+	UPROPERTY(Transient)
+	TArray<UObject*> PreloadedAssets;
+
+	FString PreloadingMap;
+	TArray<FStringAssetReference> PreloadRequested;
+	int32 PreloadSerial = 0;
+	bool bPreloadPending = false;
+
+	double BootStartTime = 0.0;
+	double MapLoadStartTime = 0.0;
+	double PreloadStartTime = 0.0;
+	bool bReportedFirstFrame = false;
+	bool bFirstMapLoaded = false;
+};
@@ -3,13 +3,166 @@
 #include "Scavenger.h"
 #include "ScavengerGameMode.h"
 #include "ScavengerCharacter.h"
+#include "ScavengerGameInstance.h"
+#include "ScavengerGameState.h"
+#include "ScavengerHUD.h"
+#include "ScavengerSkinManager.h"
+#include "GameFramework/DefaultPawn.h"
+#include "GameFramework/PlayerState.h"
+
+static void EndRoundCommand(const TArray<FString>& Args, UWorld* World)
+{
+	AScavengerGameMode* GameMode = World ? Cast<AScavengerGameMode>(World->GetAuthGameMode()) : nullptr;
+	if (GameMode) GameMode->EndRound();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs EndRoundConsoleCommand(
+	TEXT("scav.EndRound"),
+	TEXT("Ends the current round on the server, as if its time had run out."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&EndRoundCommand));
 
 AScavengerGameMode::AScavengerGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	GameStateClass = AScavengerGameState::StaticClass();
+	HUDClass = AScavengerHUD::StaticClass();
+
+	// Map changes go through the transition map, so players stay connected
+	bUseSeamlessTravel = true;
+
+	// Default pawn class is resolved in InitGame from the game instance's preloaded manifest,
+	// so nothing here forces a synchronous Blueprint load while the CDO is built
+}
+
+void AScavengerGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	UScavengerGameInstance* GameInstance = Cast<UScavengerGameInstance>(GetGameInstance());
+	if (GameInstance)
+	{
+		// A Blueprint game mode that already picked a pawn keeps it
+		if (DefaultPawnClass == nullptr || DefaultPawnClass == ADefaultPawn::StaticClass())
+		{
+			UClass* PawnClass = GameInstance->ResolveDefaultPawnClass();
+			if (PawnClass) DefaultPawnClass = PawnClass;
+		}
+	}
+
+	Super::InitGame(MapName, Options, ErrorMessage);
+}
+
+bool AScavengerGameMode::ReadyToStartMatch_Implementation()
+{
+	if (!Super::ReadyToStartMatch_Implementation()) return false;
+
+	UScavengerGameInstance* GameInstance = Cast<UScavengerGameInstance>(GetGameInstance());
+	if (GameInstance && !GameInstance->IsPreloadComplete())
+	{
+		if (PreloadWaitStartTime < 0.0f) PreloadWaitStartTime = GetWorld()->GetRealTimeSeconds();
+		if (GetWorld()->GetRealTimeSeconds() - PreloadWaitStartTime < MaxPreloadWaitTime) return false;
+
+		UE_LOG(LogScavenger, Warning, TEXT("Preload still streaming after %.1fs, starting match anyway"), MaxPreloadWaitTime);
+	}
+
+	if (GameInstance && GetNetMode() == NM_DedicatedServer) GameInstance->NotifyFirstPlayableFrame();
+
+	return true;
+}
+
+void AScavengerGameMode::SetPlayerDefaults(APawn* PlayerPawn)
+{
+	Super::SetPlayerDefaults(PlayerPawn);
+
+	// Spread over the configured skins by player, so the same player keeps theirs across respawns
+	AScavengerCharacter* Character = Cast<AScavengerCharacter>(PlayerPawn);
+	const int32 NumSkins = AScavengerSkinManager::GetNumSkins();
+	if (Character && Character->PlayerState && NumSkins > 0)
+	{
+		Character->SetSkin(1 + Character->PlayerState->PlayerId % NumSkins);
+	}
+}
+
+void AScavengerGameMode::HandleMatchHasStarted()
+{
+	Super::HandleMatchHasStarted();
+
+	StartRound();
+}
+
+void AScavengerGameMode::StartRound()
+{
+	RoundsPlayed++;
+	RoundInProgress = true;
+
+	AScavengerGameState* ScavengerGameState = Cast<AScavengerGameState>(GameState);
+	if (ScavengerGameState) ScavengerGameState->SetRoundNumber(RoundsPlayed);
+
+	if (RoundTime > 0.0f) GetWorldTimerManager().SetTimer(RoundTimerHandle, this, &AScavengerGameMode::EndRound, RoundTime, false);
+
+	UE_LOG(LogScavenger, Log, TEXT("Round %d started"), RoundsPlayed);
+}
+
+void AScavengerGameMode::EndRound()
+{
+	if (!RoundInProgress) return;
+	RoundInProgress = false;
+
+	const FString NextMap = RoundsPlayed >= RoundsPerMap ? GetNextMap() : FString();
+	if (!NextMap.IsEmpty())
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		// The server and every client start streaming the next map now
+		AScavengerGameState* ScavengerGameState = Cast<AScavengerGameState>(GameState);
+		if (ScavengerGameState) ScavengerGameState->SetNextMap(NextMap);
 	}
+
+	UE_LOG(LogScavenger, Log, TEXT("Round %d over, next round %s"), RoundsPlayed, NextMap.IsEmpty() ? TEXT("on this map") : *NextMap);
+
+	GetWorldTimerManager().SetTimer(RoundTimerHandle, this, &AScavengerGameMode::OnPostRoundTimeUp, FMath::Max(PostRoundTime, 0.01f), false);
+}
+
+void AScavengerGameMode::OnPostRoundTimeUp()
+{
+	AScavengerGameState* ScavengerGameState = Cast<AScavengerGameState>(GameState);
+	const FString NextMap = ScavengerGameState ? ScavengerGameState->GetNextMap() : FString();
+
+	if (NextMap.IsEmpty())
+	{
+		ResetPlayers();
+		StartRound();
+		return;
+	}
+
+	EndMatch();
+	GetWorld()->ServerTravel(NextMap, false);
+}
+
+void AScavengerGameMode::ResetPlayers()
+{
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = *It;
+		if (!PlayerController) continue;
+
+		AScavengerCharacter* Character = Cast<AScavengerCharacter>(PlayerController->GetPawn());
+		if (!Character)
+		{
+			if (PlayerCanRestart(PlayerController)) RestartPlayer(PlayerController);
+			continue;
+		}
+
+		AActor* Start = FindPlayerStart(PlayerController);
+		const FVector Location = Start ? Start->GetActorLocation() : Character->GetActorLocation();
+		const FRotator Rotation(0.0f, Start ? Start->GetActorRotation().Yaw : Character->GetActorRotation().Yaw, 0.0f);
+		Character->ResetForRound(Location, Rotation);
+	}
+}
+
+FString AScavengerGameMode::GetNextMap() const
+{
+	if (MapRotation.Num() == 0) return FString();
+
+	// A map that isn't in the rotation moves on to its start
+	const FString CurrentMap = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	const int32 Index = MapRotation.IndexOfByKey(CurrentMap);
+	const FString& NextMap = MapRotation[(Index + 1) % MapRotation.Num()];
+
+	return NextMap == CurrentMap ? FString() : NextMap;
 }
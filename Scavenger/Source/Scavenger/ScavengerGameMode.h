@@ -3,14 +3,64 @@
 #include "GameFramework/GameMode.h"
 #include "ScavengerGameMode.generated.h"
 
-UCLASS(minimalapi)
+UCLASS(minimalapi, Config = Game)
 class AScavengerGameMode : public AGameMode
 {
 	GENERATED_BODY()
 
 public:
 	AScavengerGameMode();
-};
 
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	// Holds the match until the map's preload manifest is resident
+	virtual bool ReadyToStartMatch_Implementation() override;
+
+	// Hands each player's character a skin
+	virtual void SetPlayerDefaults(APawn* PlayerPawn) override;
+
+	virtual void HandleMatchHasStarted() override;
+
+	/**
+	 * Ends the round in progress. The next round starts PostRoundTime later, on this map with every
+	 * character and weapon reset where it stands, or once RoundsPerMap have been played here, after a
+	 * seamless travel to the next map in MapRotation that keeps connections, controllers and player states.
+	 */
+	void EndRound();
+
+private:
+	void StartRound();
+	void OnPostRoundTimeUp();
+
+	// Puts every player back at a start with their existing character, spawning only for those without one
+	void ResetPlayers();
 
+	// Next map in MapRotation after this one, empty if the rotation never leaves this map
+	FString GetNextMap() const;
 
+	// Seconds a round lasts, 0 leaves it running until EndRound is called
+	UPROPERTY(Config)
+	float RoundTime = 300.0f;
+
+	// Seconds between rounds, which is also how long the next map's assets get to stream in before travel
+	UPROPERTY(Config)
+	float PostRoundTime = 8.0f;
+
+	// Rounds played on a map before moving on through MapRotation
+	UPROPERTY(Config)
+	int32 RoundsPerMap = 3;
+
+	// Long package names of the maps to play, in order and wrapping round
+	UPROPERTY(Config)
+	TArray<FString> MapRotation;
+
+	int32 RoundsPlayed = 0;
+	bool RoundInProgress = false;
+	FTimerHandle RoundTimerHandle;
+
+	// Longest time to hold the match for a preload before starting anyway
+	UPROPERTY(Config)
+	float MaxPreloadWaitTime = 10.0f;
+
+	float PreloadWaitStartTime = -1.0f;
+};
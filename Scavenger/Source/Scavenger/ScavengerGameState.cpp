@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerGameState.h"
+#include "ScavengerGameInstance.h"
+#include "ScavengerEffectManager.h"
+#include "ScavengerCorpseManager.h"
+#include "UnrealNetwork.h"
+
+void FScavengerCombatEvent::PostReplicatedAdd(const FScavengerCombatEventArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner) InArraySerializer.Owner->OnCombatEvent.Broadcast(*this);
+}
+
+AScavengerGameState::AScavengerGameState()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+AScavengerGameState* AScavengerGameState::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, false) : nullptr;
+	return World ? Cast<AScavengerGameState>(World->GameState) : nullptr;
+}
+
+void AScavengerGameState::GetLifetimeReplicatedProps(TArray< FLifetimeProperty > & OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AScavengerGameState, CombatEvents);
+	DOREPLIFETIME(AScavengerGameState, RoundNumber);
+	DOREPLIFETIME(AScavengerGameState, NextMap);
+}
+
+void AScavengerGameState::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	CombatEvents.Owner = this;
+	MaxEvents = FMath::Max(MaxEvents, 1);
+	CharacterHash.SetCellSize(CharacterHashCellSize);
+}
+
+void AScavengerGameState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Up as soon as the feed is, so no event arrives before there is a subscriber for it
+	AScavengerEffectManager::Get(GetWorld());
+	AScavengerCorpseManager::Get(GetWorld());
+}
+
+void AScavengerGameState::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Role == ROLE_Authority)
+	{
+		ExpireEvents();
+		FlushPendingEvents();
+	}
+}
+
+void AScavengerGameState::SetNextMap(const FString& Map)
+{
+	if (Role < ROLE_Authority) return;
+
+	NextMap = Map;
+	OnRep_NextMap();
+}
+
+void AScavengerGameState::OnRep_NextMap()
+{
+	// Streams while the round's over, so the map change has less left to load
+	UScavengerGameInstance* GameInstance = UScavengerGameInstance::Get(this);
+	if (GameInstance && !NextMap.IsEmpty()) GameInstance->PreloadForMap(NextMap);
+}
+
+void AScavengerGameState::AddCombatEvent(EScavengerCombatEventType Type, AActor* Instigator, AActor* Victim, const FVector& Location, const FVector& Normal, float Damage)
+{
+	if (Role < ROLE_Authority) return;
+
+	FScavengerCombatEvent Event;
+	Event.Type = Type;
+	Event.Instigator = Instigator;
+	Event.Victim = Victim;
+	Event.Location = Location;
+	Event.Normal = Normal.GetSafeNormal();
+	Event.Damage = (uint8)FMath::Clamp(FMath::RoundToInt(Damage), 0, 255);
+	PendingEvents.Add(Event);
+}
+
+void AScavengerGameState::FlushPendingEvents()
+{
+	if (PendingEvents.Num() == 0) return;
+
+	const float ExpireTime = GetWorld()->GetTimeSeconds() + EventLifetime;
+
+	// More in one frame than the feed holds: hits and impacts go before kills, then the oldest
+	for (int32 i = 0; i < PendingEvents.Num() && PendingEvents.Num() > MaxEvents; )
+	{
+		if (PendingEvents[i].Type != EScavengerCombatEventType::Kill) PendingEvents.RemoveAt(i);
+		else i++;
+	}
+	if (PendingEvents.Num() > MaxEvents) PendingEvents.RemoveAt(0, PendingEvents.Num() - MaxEvents);
+
+	// Make room first so this frame's events never push each other out
+	const int32 Overflow = CombatEvents.Items.Num() + PendingEvents.Num() - MaxEvents;
+	if (Overflow > 0)
+	{
+		CombatEvents.Items.RemoveAt(0, FMath::Min(Overflow, CombatEvents.Items.Num()));
+		CombatEvents.MarkArrayDirty();
+	}
+
+	for (FScavengerCombatEvent& Event : PendingEvents)
+	{
+		Event.ExpireTime = ExpireTime;
+		FScavengerCombatEvent& Added = CombatEvents.Items[CombatEvents.Items.Add(Event)];
+		CombatEvents.MarkItemDirty(Added);
+
+		// Listen servers and standalone games don't receive their own replication
+		OnCombatEvent.Broadcast(Added);
+	}
+
+	PendingEvents.Reset();
+}
+
+void AScavengerGameState::ExpireEvents()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Items are appended in time order, so expired ones are always at the front
+	int32 NumExpired = 0;
+	while (NumExpired < CombatEvents.Items.Num() && CombatEvents.Items[NumExpired].ExpireTime <= Now) NumExpired++;
+
+	if (NumExpired > 0)
+	{
+		CombatEvents.Items.RemoveAt(0, NumExpired);
+		CombatEvents.MarkArrayDirty();
+	}
+}
+
+SIZE_T AScavengerGameState::GetResourceSize(EResourceSizeMode::Type Mode)
+{
+	// Items in the replicated feed are a property and counted with the object
+	return Super::GetResourceSize(Mode) + PendingEvents.GetAllocatedSize() + CharacterHash.GetAllocatedSize();
+}
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/GameState.h"
+#include "Engine/NetSerialization.h"
+#include "ScavengerCharacterHash.h"
+#include "ScavengerGameState.generated.h"
+
+UENUM(BlueprintType)
+enum class EScavengerCombatEventType : uint8
+{
+	Hit,
+	Kill,
+	Impact
+};
+
+// One entry in the combat feed. Kept small, everything that can be is quantized.
+USTRUCT(BlueprintType)
+struct FScavengerCombatEvent : public FFastArraySerializerItem
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = Combat)
+	EScavengerCombatEventType Type = EScavengerCombatEventType::Hit;
+
+	UPROPERTY(BlueprintReadOnly, Category = Combat)
+	AActor* Instigator = nullptr;
+
+	// Null for impacts against the world
+	UPROPERTY(BlueprintReadOnly, Category = Combat)
+	AActor* Victim = nullptr;
+
+	UPROPERTY(BlueprintReadOnly, Category = Combat)
+	FVector_NetQuantize Location;
+
+	UPROPERTY(BlueprintReadOnly, Category = Combat)
+	FVector_NetQuantizeNormal Normal;
+
+	// Whole points of damage, capped at 255
+	UPROPERTY(BlueprintReadOnly, Category = Combat)
+	uint8 Damage = 0;
+
+	// Server time the event stops being replicated
+	UPROPERTY(NotReplicated)
+	float ExpireTime = 0.0f;
+
+	void PostReplicatedAdd(const struct FScavengerCombatEventArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FScavengerCombatEventArray : public FFastArraySerializer
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+	TArray<FScavengerCombatEvent> Items;
+
+	UPROPERTY(NotReplicated)
+	class AScavengerGameState* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FScavengerCombatEvent>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FScavengerCombatEventArray> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FScavengerCombatEventDelegate, const FScavengerCombatEvent&, Event);
+
+/**
+ * Per-match state. Carries the round number and, once a round ends on a map change, the map being
+ * travelled to so clients start streaming it in early. Also carries the combat feed: hits, kills and impacts recorded by the server during a
+ * frame go out together in the feed's next delta instead of one RPC each, and drop out on their own
+ * once they are older than EventLifetime.
+ */
+UCLASS(Config = Game)
+class SCAVENGER_API AScavengerGameState : public AGameState
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerGameState();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual SIZE_T GetResourceSize(EResourceSizeMode::Type Mode) override;
+
+	// Server only. Queued and committed to the feed once per frame.
+	void AddCombatEvent(EScavengerCombatEventType Type, AActor* Instigator, AActor* Victim, const FVector& Location, const FVector& Normal, float Damage);
+
+	// Fires on every machine for each event, including the server's own
+	UPROPERTY(BlueprintAssignable, Category = Combat)
+	FScavengerCombatEventDelegate OnCombatEvent;
+
+	static AScavengerGameState* Get(const UObject* WorldContextObject);
+
+	// Server only
+	void SetRoundNumber(int32 InRoundNumber) { RoundNumber = InRoundNumber; }
+	void SetNextMap(const FString& Map);
+
+	// Rounds started on this map so far, counting the current one
+	int32 GetRoundNumber() const { return RoundNumber; }
+
+	// Map the server travels to at the end of this round, empty while the next round stays on this map
+	const FString& GetNextMap() const { return NextMap; }
+
+	// Characters in play by location, for lookups that mustn't scale with player count. Not kept on dedicated servers.
+	FScavengerCharacterHash& GetCharacterHash() { return CharacterHash; }
+
+private:
+	friend struct FScavengerCombatEvent;
+
+	void FlushPendingEvents();
+	void ExpireEvents();
+
+	UFUNCTION()
+	void OnRep_NextMap();
+
+	UPROPERTY(Replicated)
+	int32 RoundNumber = 0;
+
+	UPROPERTY(ReplicatedUsing = OnRep_NextMap)
+	FString NextMap;
+
+	UPROPERTY(Replicated)
+	FScavengerCombatEventArray CombatEvents;
+
+	TArray<FScavengerCombatEvent> PendingEvents;
+
+	// Seconds an event stays in the feed, long enough for a client at a low update rate to see it
+	UPROPERTY(Config)
+	float EventLifetime = 2.0f;
+
+	// Hard cap on live events, oldest go first
+	UPROPERTY(Config)
+	int32 MaxEvents = 128;
+
+	FScavengerCharacterHash CharacterHash;
+
+	// Edge of a character hash cell, roughly the range a single query needs to cover in one step
+	UPROPERTY(Config)
+	float CharacterHashCellSize = 1000.0f;
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerHUD.h"
+#include "ScavengerCharacter.h"
+#include "CanvasItem.h"
+
+AScavengerHUD::AScavengerHUD()
+{
+	// Crosshair work is driven by the character's own tick, nothing to do per frame here
+	PrimaryActorTick.bCanEverTick = false;
+
+	CrosshairTextureRef = FStringAssetReference(TEXT("/Game/HUD/Crosshair.Crosshair"));
+}
+
+void AScavengerHUD::BeginPlay()
+{
+	Super::BeginPlay();
+
+	CrosshairTexture = Cast<UTexture2D>(CrosshairTextureRef.TryLoad());
+}
+
+FVector2D AScavengerHUD::GetCrosshairPosition() const
+{
+	int32 ViewportX = 0;
+	int32 ViewportY = 0;
+	if (PlayerOwner) PlayerOwner->GetViewportSize(ViewportX, ViewportY);
+
+	return FVector2D(ViewportX * 0.5f, ViewportY * 0.5f) + CrosshairOffset;
+}
+
+void AScavengerHUD::UpdateCrosshair(AScavengerCharacter* Character)
+{
+	if (!Character || !PlayerOwner) return;
+
+	int32 ViewportX = 0;
+	int32 ViewportY = 0;
+	PlayerOwner->GetViewportSize(ViewportX, ViewportY);
+	if (ViewportX <= 0 || ViewportY <= 0) return;
+
+	const FVector2D Crosshair = GetCrosshairPosition();
+	UCameraComponent* Camera = Character->GetFollowCamera();
+
+	if (!Camera)
+	{
+		// Falls back to last frame's view
+		PlayerOwner->DeprojectScreenPositionToWorld(Crosshair.X, Crosshair.Y, Character->CrosshairLocationCPP, Character->CrosshairRayCPP);
+		return;
+	}
+
+	// Deproject against the camera as it is now rather than the view the last frame was rendered with.
+	// Horizontal FOV is fixed, so the vertical extent scales with the viewport's aspect ratio.
+	const float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(Camera->FieldOfView * 0.5f));
+	const float ScreenX = (2.0f * Crosshair.X / ViewportX - 1.0f) * TanHalfFOV;
+	const float ScreenY = (1.0f - 2.0f * Crosshair.Y / ViewportY) * TanHalfFOV * ViewportY / ViewportX;
+
+	const FTransform CameraTransform = Camera->GetComponentTransform();
+	const FVector Ray = CameraTransform.GetUnitAxis(EAxis::X)
+		+ CameraTransform.GetUnitAxis(EAxis::Y) * ScreenX
+		+ CameraTransform.GetUnitAxis(EAxis::Z) * ScreenY;
+
+	Character->CrosshairLocationCPP = CameraTransform.GetLocation();
+	Character->CrosshairRayCPP = Ray.GetSafeNormal();
+}
+
+void AScavengerHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	AScavengerCharacter* Character = PlayerOwner ? Cast<AScavengerCharacter>(PlayerOwner->GetPawn()) : nullptr;
+	if (!Character || !Canvas) return;
+
+	// Untextured tiles first and the crosshair last, so the canvas batches each run into one draw
+	const FVector2D BarPosition(Canvas->ClipX * HealthBarPosition.X, Canvas->ClipY * HealthBarPosition.Y);
+	const FVector2D BarSize(Canvas->ClipX * HealthBarSize.X, Canvas->ClipY * HealthBarSize.Y);
+	const float HealthFraction = Character->MaxHealth > 0.0f ? FMath::Clamp(Character->HealthCPP / Character->MaxHealth, 0.0f, 1.0f) : 0.0f;
+
+	FCanvasTileItem BarBack(BarPosition, BarSize, FLinearColor(0.0f, 0.0f, 0.0f, 0.5f));
+	BarBack.BlendMode = SE_BLEND_Translucent;
+	Canvas->DrawItem(BarBack);
+
+	FCanvasTileItem BarFill(BarPosition, FVector2D(BarSize.X * HealthFraction, BarSize.Y), FLinearColor::LerpUsingHSV(FLinearColor::Red, FLinearColor::Green, HealthFraction));
+	BarFill.BlendMode = SE_BLEND_Translucent;
+	Canvas->DrawItem(BarFill);
+
+	if (CrosshairTexture && !Character->IsDeadCPP)
+	{
+		const FVector2D Crosshair = GetCrosshairPosition();
+		FCanvasTileItem CrosshairTile(Crosshair - FVector2D(CrosshairSize, CrosshairSize) * 0.5f, CrosshairTexture->Resource, FVector2D(CrosshairSize, CrosshairSize), FLinearColor::White);
+		CrosshairTile.BlendMode = SE_BLEND_Translucent;
+		Canvas->DrawItem(CrosshairTile);
+	}
+}
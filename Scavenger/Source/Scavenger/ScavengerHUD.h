@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/HUD.h"
+#include "ScavengerHUD.generated.h"
+
+class AScavengerCharacter;
+
+/**
+ * Native HUD for the local player. Works out the crosshair's world ray for the character right
+ * before it aims each frame, and draws the crosshair and health bar as batched canvas tiles.
+ */
+UCLASS(Config = Game)
+class SCAVENGER_API AScavengerHUD : public AHUD
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerHUD();
+
+	virtual void BeginPlay() override;
+	virtual void DrawHUD() override;
+
+	// Fills in the character's crosshair origin and ray from its camera as it stands this frame
+	void UpdateCrosshair(AScavengerCharacter* Character);
+
+	// Where the crosshair sits on screen in pixels
+	FVector2D GetCrosshairPosition() const;
+
+private:
+	UPROPERTY(Config)
+	FStringAssetReference CrosshairTextureRef;
+
+	// Pixels from the centre of the screen to the crosshair
+	UPROPERTY(Config)
+	FVector2D CrosshairOffset = FVector2D::ZeroVector;
+
+	UPROPERTY(Config)
+	float CrosshairSize = 32.0f;
+
+	// Health bar size and position, as fractions of the screen
+	UPROPERTY(Config)
+	FVector2D HealthBarPosition = FVector2D(0.03f, 0.92f);
+
+	UPROPERTY(Config)
+	FVector2D HealthBarSize = FVector2D(0.2f, 0.02f);
+
+	UPROPERTY(Transient)
+	UTexture2D* CrosshairTexture = nullptr;
+};
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerHitResolver.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerStats.h"
+
+void FScavengerHitResolver::Resolve(
+	UWorld* World,
+	AActor* Shooter,
+	const FVector& Origin,
+	const TArray<FVector>& Directions,
+	float Range,
+	TArray<FScavengerPelletHit>& OutHits)
+{
+	const int32 NumPellets = Directions.Num();
+	if (!World || NumPellets == 0) return;
+
+	// Directions go structure-of-arrays, padded to a whole number of 4-wide groups
+	const int32 NumPadded = Align(NumPellets, 4);
+	TArray<float> DirX, DirY, DirZ, Distances;
+	DirX.SetNumZeroed(NumPadded);
+	DirY.SetNumZeroed(NumPadded);
+	DirZ.SetNumZeroed(NumPadded);
+	Distances.SetNumUninitialized(NumPadded);
+
+	FBox Bounds(Origin, Origin);
+	for (int32 i = 0; i < NumPellets; i++)
+	{
+		const FVector Direction = Directions[i].GetSafeNormal();
+		DirX[i] = Direction.X;
+		DirY[i] = Direction.Y;
+		DirZ[i] = Direction.Z;
+		Bounds += Origin + Direction * Range;
+	}
+
+	// Broadphase: one overlap around the whole pattern finds every capsule any pellet could touch
+	FCollisionQueryParams QueryParams(FName(TEXT("PelletBroadphase")), false, Shooter);
+	TArray<FOverlapResult> Overlaps;
+	SCAV_COUNT_TRACE(1);
+	World->OverlapMultiByObjectType(
+		Overlaps,
+		Bounds.GetCenter(),
+		FQuat::Identity,
+		FCollisionObjectQueryParams(ECollisionChannel::ECC_Pawn),
+		FCollisionShape::MakeBox(Bounds.GetExtent()),
+		QueryParams
+	);
+
+	TArray<float> BestDistance;
+	TArray<AScavengerCharacter*> BestCharacter;
+	BestDistance.Init(MAX_FLT, NumPellets);
+	BestCharacter.Init(nullptr, NumPellets);
+
+	TArray<AScavengerCharacter*, TInlineAllocator<16>> Tested;
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AScavengerCharacter* Character = Cast<AScavengerCharacter>(Overlap.GetActor());
+		if (!Character || Character == Shooter || Character->IsDeadCPP) continue;
+		if (Tested.Contains(Character)) continue;
+		Tested.Add(Character);
+
+		UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		const float Radius = Capsule->GetScaledCapsuleRadius();
+		const FVector Axis = Capsule->GetUpVector() * (Capsule->GetScaledCapsuleHalfHeight() - Radius);
+		const FVector Center = Capsule->GetComponentLocation();
+
+		IntersectCapsule(Origin, DirX.GetData(), DirY.GetData(), DirZ.GetData(), NumPadded, Range,
+			Center - Axis, Center + Axis, Radius, Distances.GetData());
+
+		for (int32 i = 0; i < NumPellets; i++)
+		{
+			if (Distances[i] >= 0.0f && Distances[i] < BestDistance[i])
+			{
+				BestDistance[i] = Distances[i];
+				BestCharacter[i] = Character;
+			}
+		}
+	}
+
+	if (Tested.Num() == 0) return;
+
+	// Only pellets that reached someone need to know whether the world got in the way first
+	FCollisionObjectQueryParams WorldObjects;
+	WorldObjects.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldStatic);
+	WorldObjects.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldDynamic);
+	FCollisionQueryParams OcclusionParams(FName(TEXT("PelletOcclusion")), false, Shooter);
+
+	// The gun, and anything else the shooter carries, is right in front of the muzzle and mustn't stop its own shot
+	if (Shooter)
+	{
+		TArray<AActor*> Carried;
+		Shooter->GetAttachedActors(Carried);
+		for (AActor* Actor : Carried) OcclusionParams.AddIgnoredActor(Actor);
+	}
+
+	for (int32 i = 0; i < NumPellets; i++)
+	{
+		if (!BestCharacter[i]) continue;
+
+		const FVector HitLocation = Origin + FVector(DirX[i], DirY[i], DirZ[i]) * BestDistance[i];
+		SCAV_COUNT_TRACE(1);
+		if (World->LineTraceTestByObjectType(Origin, HitLocation, WorldObjects, OcclusionParams)) continue;
+
+		FScavengerPelletHit Hit;
+		Hit.Pellet = i;
+		Hit.Character = BestCharacter[i];
+		Hit.Location = HitLocation;
+		Hit.Distance = BestDistance[i];
+		OutHits.Add(Hit);
+	}
+}
+
+void FScavengerHitResolver::IntersectCapsule(
+	const FVector& Origin,
+	const float* DirX, const float* DirY, const float* DirZ, int32 NumRays,
+	float Range,
+	const FVector& CapsuleA, const FVector& CapsuleB, float CapsuleRadius,
+	float* OutDistances)
+{
+	// Closest approach between each ray segment O + D*s (s in [0, Range]) and the capsule's
+	// core segment A + E*t (t in [0, 1]); a ray hits when that distance is within the radius.
+	// Everything that depends only on the capsule is worked out once, the rest runs 4 rays at a time.
+	const FVector E = CapsuleB - CapsuleA;
+	const FVector R = Origin - CapsuleA;
+	const float EE = FMath::Max(FVector::DotProduct(E, E), KINDA_SMALL_NUMBER);
+	const float F = FVector::DotProduct(E, R);
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister MinusOne = VectorSetFloat1(-1.0f);
+	const VectorRegister Epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const VectorRegister RangeV = VectorSetFloat1(Range);
+	const VectorRegister EEv = VectorSetFloat1(EE);
+	const VectorRegister InvEE = VectorSetFloat1(1.0f / EE);
+	const VectorRegister Fv = VectorSetFloat1(F);
+	const VectorRegister RadiusSq = VectorSetFloat1(CapsuleRadius * CapsuleRadius);
+	const VectorRegister Ex = VectorSetFloat1(E.X), Ey = VectorSetFloat1(E.Y), Ez = VectorSetFloat1(E.Z);
+	const VectorRegister Rx = VectorSetFloat1(R.X), Ry = VectorSetFloat1(R.Y), Rz = VectorSetFloat1(R.Z);
+
+	for (int32 i = 0; i < NumRays; i += 4)
+	{
+		const VectorRegister Dx = VectorLoad(DirX + i);
+		const VectorRegister Dy = VectorLoad(DirY + i);
+		const VectorRegister Dz = VectorLoad(DirZ + i);
+
+		// b = D.E, c = D.R
+		const VectorRegister B = VectorMultiplyAdd(Dz, Ez, VectorMultiplyAdd(Dy, Ey, VectorMultiply(Dx, Ex)));
+		const VectorRegister C = VectorMultiplyAdd(Dz, Rz, VectorMultiplyAdd(Dy, Ry, VectorMultiply(Dx, Rx)));
+
+		// s = (b*f - c*e) / (e - b*b), zero when the ray runs parallel to the capsule
+		const VectorRegister Denom = VectorSubtract(EEv, VectorMultiply(B, B));
+		const VectorRegister Numer = VectorSubtract(VectorMultiply(B, Fv), VectorMultiply(C, EEv));
+		const VectorRegister Parallel = VectorCompareGT(Epsilon, Denom);
+		VectorRegister S = VectorMultiply(Numer, VectorReciprocalAccurate(VectorMax(Denom, Epsilon)));
+		S = VectorSelect(Parallel, Zero, S);
+		S = VectorMin(VectorMax(S, Zero), RangeV);
+
+		// t = (b*s + f) / e, clamped to the segment with s recomputed for the clamped end
+		VectorRegister T = VectorMultiply(VectorMultiplyAdd(B, S, Fv), InvEE);
+		const VectorRegister BelowA = VectorCompareGT(Zero, T);
+		const VectorRegister AboveB = VectorCompareGT(T, One);
+		const VectorRegister SAtA = VectorMin(VectorMax(VectorNegate(C), Zero), RangeV);
+		const VectorRegister SAtB = VectorMin(VectorMax(VectorSubtract(B, C), Zero), RangeV);
+		S = VectorSelect(BelowA, SAtA, VectorSelect(AboveB, SAtB, S));
+		T = VectorMin(VectorMax(T, Zero), One);
+
+		// Squared distance between the closest points: (R + D*s) - E*t
+		const VectorRegister Px = VectorSubtract(VectorMultiplyAdd(Dx, S, Rx), VectorMultiply(Ex, T));
+		const VectorRegister Py = VectorSubtract(VectorMultiplyAdd(Dy, S, Ry), VectorMultiply(Ey, T));
+		const VectorRegister Pz = VectorSubtract(VectorMultiplyAdd(Dz, S, Rz), VectorMultiply(Ez, T));
+		const VectorRegister DistSq = VectorMultiplyAdd(Pz, Pz, VectorMultiplyAdd(Py, Py, VectorMultiply(Px, Px)));
+
+		// Back off from the closest point to roughly where the ray enters the capsule
+		const VectorRegister Slack = VectorMax(VectorSubtract(RadiusSq, DistSq), Epsilon);
+		const VectorRegister Entry = VectorMax(VectorSubtract(S, VectorMultiply(Slack, VectorReciprocalSqrtAccurate(Slack))), Zero);
+
+		const VectorRegister Hit = VectorCompareGE(RadiusSq, DistSq);
+		VectorStore(VectorSelect(Hit, Entry, MinusOne), OutDistances + i);
+	}
+}
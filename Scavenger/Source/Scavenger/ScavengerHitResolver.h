@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AScavengerCharacter;
+
+// One pellet that reached a character
+struct FScavengerPelletHit
+{
+	int32 Pellet = INDEX_NONE;
+	AScavengerCharacter* Character = nullptr;
+	FVector Location = FVector::ZeroVector;
+	float Distance = 0.0f;
+};
+
+/**
+ * Resolves a whole pellet pattern against characters in one go.
+ * Candidate capsules come from a single broadphase overlap around the pattern, every pellet is tested
+ * against every candidate four pellets at a time, and world geometry is only traced for pellets
+ * that found a character, to check nothing solid is in the way.
+ */
+struct FScavengerHitResolver
+{
+	static void Resolve(
+		UWorld* World,
+		AActor* Shooter,
+		const FVector& Origin,
+		const TArray<FVector>& Directions,
+		float Range,
+		TArray<FScavengerPelletHit>& OutHits);
+
+	// Distance along each ray to where it first enters the capsule, or -1 for a miss. OutDistances must hold NumRays.
+	static void IntersectCapsule(
+		const FVector& Origin,
+		const float* DirX, const float* DirY, const float* DirZ, int32 NumRays,
+		float Range,
+		const FVector& CapsuleA, const FVector& CapsuleB, float CapsuleRadius,
+		float* OutDistances);
+};
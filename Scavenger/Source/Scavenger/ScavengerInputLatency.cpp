@@ -0,0 +1,240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerInputLatency.h"
+
+int32 FScavengerInputLatency::Enabled = 0;
+
+static FAutoConsoleVariableRef CVarInputLatency(
+	TEXT("scav.InputLatency"),
+	FScavengerInputLatency::Enabled,
+	TEXT("Measure input-to-effect latency for the local player. Report with scav.InputLatencyReport."),
+	ECVF_Default);
+
+namespace ScavengerInputLatency
+{
+	// Upper bounds of the histogram buckets in milliseconds, the last bucket takes the rest
+	static const int32 NumBuckets = 12;
+	static const double BucketBoundsMs[NumBuckets - 1] = { 8.0, 16.0, 33.0, 50.0, 66.0, 100.0, 150.0, 200.0, 300.0, 500.0, 1000.0 };
+
+	// Longer than this and the input is taken to have had no effect
+	static const double MaxPendingSeconds = 2.0;
+
+	struct FHistogram
+	{
+		uint32 Buckets[NumBuckets];
+		uint32 Count;
+		double SumMs;
+		double MaxMs;
+	};
+
+	struct FPending
+	{
+		double Start = 0.0;
+		// Bit per EScavengerLatencyStage still to be observed
+		uint8 Stages = 0;
+	};
+
+	static FHistogram Histograms[(int32)EScavengerInputAction::Count][(int32)EScavengerLatencyStage::Count];
+	static FPending Pending[(int32)EScavengerInputAction::Count];
+	static uint32 Dropped[(int32)EScavengerInputAction::Count];
+
+	// Packet lag set by scav.InputLatencyEmulate, for the report
+	static int32 EmulatedLagMs = 0;
+	static int32 EmulatedLagVarianceMs = 0;
+
+	static uint8 StageBit(EScavengerLatencyStage Stage)
+	{
+		return 1 << (uint8)Stage;
+	}
+
+	// Movement is predicted and acked inside the movement component, so only its local effect is measured
+	static uint8 GetExpectedStages(EScavengerInputAction Action)
+	{
+		if (Action == EScavengerInputAction::Move) return StageBit(EScavengerLatencyStage::Local);
+		return StageBit(EScavengerLatencyStage::Local) | StageBit(EScavengerLatencyStage::Ack);
+	}
+
+	// The input that undoes Action, Count if there is none
+	static EScavengerInputAction GetOpposite(EScavengerInputAction Action)
+	{
+		switch (Action)
+		{
+		case EScavengerInputAction::Aim: return EScavengerInputAction::StopAim;
+		case EScavengerInputAction::StopAim: return EScavengerInputAction::Aim;
+		case EScavengerInputAction::Run: return EScavengerInputAction::StopRun;
+		case EScavengerInputAction::StopRun: return EScavengerInputAction::Run;
+		default: return EScavengerInputAction::Count;
+		}
+	}
+
+	// Bucket bound the given fraction of samples falls under, as text
+	static FString GetPercentile(const FHistogram& Histogram, double Fraction)
+	{
+		const uint32 Target = FMath::Max(1u, (uint32)FMath::CeilToInt(Histogram.Count * Fraction));
+		uint32 Cumulative = 0;
+		for (int32 i = 0; i < NumBuckets - 1; i++)
+		{
+			Cumulative += Histogram.Buckets[i];
+			if (Cumulative >= Target) return FString::Printf(TEXT("<=%.0fms"), BucketBoundsMs[i]);
+		}
+		return FString::Printf(TEXT(">%.0fms"), BucketBoundsMs[NumBuckets - 2]);
+	}
+
+	static void ReportCommand()
+	{
+		FScavengerInputLatency::Report();
+	}
+
+	static void ResetCommand()
+	{
+		FScavengerInputLatency::Reset();
+	}
+
+	static void EmulateCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		EmulatedLagMs = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0;
+		EmulatedLagVarianceMs = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 0;
+
+		// Applies to this machine's outgoing packets, which is every input's trip to the server
+		if (GEngine && World)
+		{
+			GEngine->Exec(World, *FString::Printf(TEXT("Net PktLag=%d"), EmulatedLagMs));
+			GEngine->Exec(World, *FString::Printf(TEXT("Net PktLagVariance=%d"), EmulatedLagVarianceMs));
+		}
+
+		// Measure from scratch at the new lag
+		FScavengerInputLatency::Enabled = 1;
+		FScavengerInputLatency::Reset();
+		UE_LOG(LogScavenger, Log, TEXT("Emulating %dms (+/- %dms) outgoing packet lag, input latency measurement reset"), EmulatedLagMs, EmulatedLagVarianceMs);
+	}
+
+	static FAutoConsoleCommand ReportConsoleCommand(
+		TEXT("scav.InputLatencyReport"),
+		TEXT("Logs input-to-effect latency histograms per action."),
+		FConsoleCommandDelegate::CreateStatic(&ReportCommand));
+
+	static FAutoConsoleCommand ResetConsoleCommand(
+		TEXT("scav.InputLatencyReset"),
+		TEXT("Clears the input latency histograms."),
+		FConsoleCommandDelegate::CreateStatic(&ResetCommand));
+
+	static FAutoConsoleCommandWithWorldAndArgs EmulateConsoleCommand(
+		TEXT("scav.InputLatencyEmulate"),
+		TEXT("Adds LagMs [VarianceMs] of outgoing packet lag, turns measurement on and resets it. 0 turns the lag off. Not in shipping builds."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&EmulateCommand));
+}
+
+using namespace ScavengerInputLatency;
+
+void FScavengerInputLatency::Begin(EScavengerInputAction Action)
+{
+	if (!IsEnabled()) return;
+
+	// Undoing an input before it has taken effect leaves the state both of them wait for where it
+	// started, so either would be timed from something that never changed. Neither is measured.
+	const EScavengerInputAction Opposite = GetOpposite(Action);
+	if (Opposite != EScavengerInputAction::Count && Pending[(int32)Opposite].Stages)
+	{
+		Pending[(int32)Opposite] = FPending();
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	FPending& Input = Pending[(int32)Action];
+	if (Input.Stages)
+	{
+		if (Now - Input.Start < MaxPendingSeconds) return;
+		Dropped[(int32)Action]++;
+	}
+
+	Input.Start = Now;
+	Input.Stages = GetExpectedStages(Action);
+}
+
+void FScavengerInputLatency::Observe(EScavengerInputAction Action, EScavengerLatencyStage Stage)
+{
+	FPending& Input = Pending[(int32)Action];
+	if (!(Input.Stages & StageBit(Stage))) return;
+
+	const double ElapsedMs = (FPlatformTime::Seconds() - Input.Start) * 1000.0;
+	if (ElapsedMs > MaxPendingSeconds * 1000.0)
+	{
+		Input.Stages = 0;
+		Dropped[(int32)Action]++;
+		return;
+	}
+	Input.Stages &= ~StageBit(Stage);
+
+	int32 Bucket = 0;
+	while (Bucket < NumBuckets - 1 && ElapsedMs > BucketBoundsMs[Bucket]) Bucket++;
+
+	FHistogram& Histogram = Histograms[(int32)Action][(int32)Stage];
+	Histogram.Buckets[Bucket]++;
+	Histogram.Count++;
+	Histogram.SumMs += ElapsedMs;
+	Histogram.MaxMs = FMath::Max(Histogram.MaxMs, ElapsedMs);
+}
+
+bool FScavengerInputLatency::IsPending(EScavengerInputAction Action)
+{
+	return Pending[(int32)Action].Stages != 0;
+}
+
+void FScavengerInputLatency::Report()
+{
+	UE_LOG(LogScavenger, Log, TEXT("Input latency, emulated packet lag %dms (+/- %dms):"), EmulatedLagMs, EmulatedLagVarianceMs);
+
+	for (int32 Action = 0; Action < (int32)EScavengerInputAction::Count; Action++)
+	{
+		for (int32 Stage = 0; Stage < (int32)EScavengerLatencyStage::Count; Stage++)
+		{
+			const FHistogram& Histogram = Histograms[Action][Stage];
+			if (!Histogram.Count) continue;
+
+			FString Buckets;
+			for (int32 i = 0; i < NumBuckets; i++)
+			{
+				if (i < NumBuckets - 1) Buckets += FString::Printf(TEXT(" <=%.0f:%u"), BucketBoundsMs[i], Histogram.Buckets[i]);
+				else Buckets += FString::Printf(TEXT(" more:%u"), Histogram.Buckets[i]);
+			}
+
+			UE_LOG(LogScavenger, Log, TEXT("  %-10s %-6s n=%u mean=%.1fms p50%s p95%s max=%.1fms |%s"),
+				GetActionName((EScavengerInputAction)Action), GetStageName((EScavengerLatencyStage)Stage),
+				Histogram.Count, Histogram.SumMs / Histogram.Count, *GetPercentile(Histogram, 0.5), *GetPercentile(Histogram, 0.95), Histogram.MaxMs, *Buckets);
+		}
+
+		if (Dropped[Action]) UE_LOG(LogScavenger, Log, TEXT("  %-10s %u inputs had no effect"), GetActionName((EScavengerInputAction)Action), Dropped[Action]);
+	}
+}
+
+void FScavengerInputLatency::Reset()
+{
+	FMemory::Memzero(Histograms, sizeof(Histograms));
+	FMemory::Memzero(Dropped, sizeof(Dropped));
+	for (FPending& Input : Pending) Input = FPending();
+}
+
+const TCHAR* FScavengerInputLatency::GetActionName(EScavengerInputAction Action)
+{
+	switch (Action)
+	{
+	case EScavengerInputAction::Aim: return TEXT("Aim");
+	case EScavengerInputAction::StopAim: return TEXT("StopAim");
+	case EScavengerInputAction::Run: return TEXT("Run");
+	case EScavengerInputAction::StopRun: return TEXT("StopRun");
+	case EScavengerInputAction::TakeCover: return TEXT("TakeCover");
+	case EScavengerInputAction::Move: return TEXT("Move");
+	default: return TEXT("Unknown");
+	}
+}
+
+const TCHAR* FScavengerInputLatency::GetStageName(EScavengerLatencyStage Stage)
+{
+	switch (Stage)
+	{
+	case EScavengerLatencyStage::Local: return TEXT("Local");
+	case EScavengerLatencyStage::Ack: return TEXT("Ack");
+	default: return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Player inputs whose latency is measured
+enum class EScavengerInputAction : uint8
+{
+	Aim,
+	StopAim,
+	Run,
+	StopRun,
+	TakeCover,
+	Move,
+	Count
+};
+
+// Points at which an input's effect is measured
+enum class EScavengerLatencyStage : uint8
+{
+	// Visible on this machine: camera at its target, speed changed, character moving, in cover
+	Local,
+	// The server's resulting state has replicated back
+	Ack,
+	Count
+};
+
+/**
+ * Input-to-effect latency for the local player. An input is stamped as it reaches its binding, then
+ * each stage it expects is observed once from the character's tick; the elapsed time goes into a
+ * histogram per action and stage. Inputs that never take effect (aiming while dashing, say) time out
+ * and are counted as dropped. Switched on with scav.InputLatency, reported by scav.InputLatencyReport,
+ * and scav.InputLatencyEmulate adds network lag so the numbers can be checked against a known delay.
+ * Game thread only.
+ */
+struct SCAVENGER_API FScavengerInputLatency
+{
+	// scav.InputLatency
+	static int32 Enabled;
+
+	static bool IsEnabled() { return Enabled != 0; }
+
+	// Stamps Action, unless an earlier one is still waiting on its effects. An Action that undoes one
+	// still waiting (StopAim while an Aim is) cancels it instead, and neither is timed.
+	static void Begin(EScavengerInputAction Action);
+
+	// Records how long Action took to reach Stage, if it's waiting on it
+	static void Observe(EScavengerInputAction Action, EScavengerLatencyStage Stage);
+
+	static bool IsPending(EScavengerInputAction Action);
+
+	static void Report();
+	static void Reset();
+
+	static const TCHAR* GetActionName(EScavengerInputAction Action);
+	static const TCHAR* GetStageName(EScavengerLatencyStage Stage);
+};
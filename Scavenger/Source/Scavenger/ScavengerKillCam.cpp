@@ -0,0 +1,573 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerKillCam.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerEffectManager.h"
+#include "ScavengerWorldActor.h"
+#include "Camera/CameraActor.h"
+
+// Snapshot layout: uint8 flags, float time, uint8 record count, records, uint8 event count, events.
+// A record is uint8 slot, uint8 mask, then only the fields the mask names.
+static const uint8 FrameKeyframe = 1 << 0;
+
+static const uint8 RecordPositionDelta = 1 << 0;
+static const uint8 RecordPositionFull = 1 << 1;
+static const uint8 RecordYaw = 1 << 2;
+static const uint8 RecordGone = 1 << 3;
+
+static const uint8 NoSlot = 0xFF;
+
+static const int32 FrameHeaderBytes = 7;
+static const int32 MaxRecordBytes = 2 + 3 * sizeof(int32) + sizeof(uint16);
+static const int32 EventBytes = 3 + 3 * sizeof(int32) + 3;
+
+// Seconds the camera lingers on the death once playback runs out
+static const float PlaybackHoldTime = 1.0f;
+
+template<typename T>
+static void Put(TArray<uint8>& Out, T Value)
+{
+	const int32 At = Out.AddUninitialized(sizeof(T));
+	FMemory::Memcpy(Out.GetData() + At, &Value, sizeof(T));
+}
+
+template<typename T>
+static T Take(const uint8*& Cursor)
+{
+	T Value;
+	FMemory::Memcpy(&Value, Cursor, sizeof(T));
+	Cursor += sizeof(T);
+	return Value;
+}
+
+static FIntVector QuantizeLocation(const FVector& Location)
+{
+	return FIntVector(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Y), FMath::RoundToInt(Location.Z));
+}
+
+static bool FitsInt16(int32 Value)
+{
+	return Value >= MIN_int16 && Value <= MAX_int16;
+}
+
+AScavengerKillCam::AScavengerKillCam()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// After replication and movement, so snapshots see the frame's final state
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AScavengerKillCam* AScavengerKillCam::Get(UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_DedicatedServer) return nullptr;
+	return TScavengerWorldActor<AScavengerKillCam>::FindOrSpawn(World);
+}
+
+void AScavengerKillCam::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Everything the recorder touches is sized here and never grows, so memory is flat for the session
+	MaxTrackedCharacters = FMath::Clamp(MaxTrackedCharacters, 1, (int32)NoSlot);
+	MaxEventsPerFrame = FMath::Clamp(MaxEventsPerFrame, 0, 255);
+	KeyframeInterval = FMath::Max(KeyframeInterval, 1);
+	RecordRate = FMath::Max(RecordRate, 1.0f);
+
+	const int32 MaxFrameBytes = FrameHeaderBytes + MaxTrackedCharacters * MaxRecordBytes + MaxEventsPerFrame * EventBytes;
+
+	Slots.SetNum(MaxTrackedCharacters);
+	PrevState.SetNum(MaxTrackedCharacters);
+	NextState.SetNum(MaxTrackedCharacters);
+	Ghosts.SetNumZeroed(MaxTrackedCharacters);
+	PendingEvents.Reserve(MaxEventsPerFrame);
+	NextEvents.Reserve(MaxEventsPerFrame);
+	Scratch.Reserve(MaxFrameBytes);
+
+	Buffer.SetNumZeroed(FMath::Max(MemoryBudget, MaxFrameBytes * 2));
+	// Enough entries for the playback window plus a keyframe interval either side
+	Frames.SetNum(FMath::CeilToInt(RecordRate * PlaybackDuration) + KeyframeInterval * 2);
+}
+
+void AScavengerKillCam::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TScavengerWorldActor<AScavengerKillCam>::Register(this);
+}
+
+void AScavengerKillCam::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Playing) StopPlayback();
+
+	TScavengerWorldActor<AScavengerKillCam>::Unregister(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AScavengerKillCam::Track(AScavengerCharacter* Character)
+{
+	if (!Character) return;
+
+	int32 SlotIndex = FindSlot(Character);
+	if (SlotIndex == INDEX_NONE)
+	{
+		// A slot frees up once its character is gone and that has been recorded
+		SlotIndex = Slots.IndexOfByPredicate([](const FSlot& Slot) { return !Slot.Character.IsValid() && !Slot.Recorded.Valid; });
+		if (SlotIndex == INDEX_NONE) return;
+	}
+
+	// The ghost is dressed the way the character is now
+	const USkeletalMeshComponent* CharacterMesh = Character->GetMesh();
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.Character = Character;
+	Slot.Mesh = CharacterMesh->SkeletalMesh;
+	Slot.Materials = CharacterMesh->OverrideMaterials;
+	Slot.AnimClass = CharacterMesh->GetAnimInstance() ? CharacterMesh->GetAnimInstance()->GetClass() : nullptr;
+	Slot.MeshOffset = CharacterMesh->GetRelativeTransform();
+}
+
+int32 AScavengerKillCam::FindSlot(const AActor* Actor) const
+{
+	if (!Actor) return INDEX_NONE;
+
+	for (int32 i = 0; i < Slots.Num(); i++)
+	{
+		if (Slots[i].Character.Get() == Actor) return i;
+	}
+	return INDEX_NONE;
+}
+
+void AScavengerKillCam::HandleCombatEvent(const FScavengerCombatEvent& Event)
+{
+	if (Playing) return;
+
+	if (PendingEvents.Num() < MaxEventsPerFrame)
+	{
+		const int32 Instigator = FindSlot(Event.Instigator);
+		const int32 Victim = FindSlot(Event.Victim);
+
+		FEvent Recorded;
+		Recorded.Type = Event.Type;
+		Recorded.InstigatorSlot = Instigator == INDEX_NONE ? NoSlot : (uint8)Instigator;
+		Recorded.VictimSlot = Victim == INDEX_NONE ? NoSlot : (uint8)Victim;
+		Recorded.Location = QuantizeLocation(Event.Location);
+		for (int32 i = 0; i < 3; i++) Recorded.Normal[i] = (int8)FMath::Clamp(FMath::RoundToInt(Event.Normal[i] * 127.0f), -127, 127);
+		PendingEvents.Add(Recorded);
+	}
+
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (Event.Type == EScavengerCombatEventType::Kill && PC && Event.Victim && PC->GetPawn() == Event.Victim)
+	{
+		// Close the buffer off with the moment of death itself
+		RecordFrame(GetWorld()->GetTimeSeconds());
+		StartPlayback(Event.Instigator);
+	}
+}
+
+void AScavengerKillCam::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Playing)
+	{
+		UpdatePlayback(DeltaSeconds);
+		return;
+	}
+
+	// At most one snapshot a tick, so a long frame never costs more than a short one
+	const float Interval = 1.0f / RecordRate;
+	RecordAccumulator += DeltaSeconds;
+	if (RecordAccumulator < Interval) return;
+	RecordAccumulator = FMath::Fmod(RecordAccumulator, Interval);
+
+	RecordFrame(GetWorld()->GetTimeSeconds());
+}
+
+AScavengerKillCam::FSlotState AScavengerKillCam::Quantize(const AScavengerCharacter* Character) const
+{
+	FSlotState State;
+	State.Position = QuantizeLocation(Character->GetActorLocation());
+	State.Yaw = FRotator::CompressAxisToShort(Character->GetActorRotation().Yaw);
+	State.Valid = true;
+	return State;
+}
+
+void AScavengerKillCam::RecordFrame(float Time)
+{
+	const bool Keyframe = FramesSinceKeyframe == 0;
+	FramesSinceKeyframe = (FramesSinceKeyframe + 1) % KeyframeInterval;
+
+	Scratch.Reset();
+	Put<uint8>(Scratch, Keyframe ? FrameKeyframe : 0);
+	Put<float>(Scratch, Time);
+	const int32 RecordCountAt = Scratch.Num();
+	Put<uint8>(Scratch, 0);
+
+	uint8 NumRecords = 0;
+	for (int32 i = 0; i < Slots.Num(); i++)
+	{
+		FSlot& Slot = Slots[i];
+		const AScavengerCharacter* Character = Slot.Character.Get();
+
+		if (!Character)
+		{
+			if (Slot.Recorded.Valid)
+			{
+				Put<uint8>(Scratch, (uint8)i);
+				Put<uint8>(Scratch, RecordGone);
+				NumRecords++;
+			}
+			if (Slot.Recorded.Valid || Slot.Mesh) Slot = FSlot();
+			continue;
+		}
+
+		const FSlotState Now = Quantize(Character);
+		const FIntVector Delta = Now.Position - Slot.Recorded.Position;
+
+		uint8 Mask = 0;
+		if (Keyframe || !Slot.Recorded.Valid)
+		{
+			Mask = RecordPositionFull | RecordYaw;
+		}
+		else
+		{
+			if (Delta != FIntVector::ZeroValue)
+			{
+				Mask |= FitsInt16(Delta.X) && FitsInt16(Delta.Y) && FitsInt16(Delta.Z) ? RecordPositionDelta : RecordPositionFull;
+			}
+			if (Now.Yaw != Slot.Recorded.Yaw) Mask |= RecordYaw;
+		}
+
+		Slot.Recorded = Now;
+		if (Mask == 0) continue;
+
+		Put<uint8>(Scratch, (uint8)i);
+		Put<uint8>(Scratch, Mask);
+		if (Mask & RecordPositionFull)
+		{
+			Put<int32>(Scratch, Now.Position.X);
+			Put<int32>(Scratch, Now.Position.Y);
+			Put<int32>(Scratch, Now.Position.Z);
+		}
+		else if (Mask & RecordPositionDelta)
+		{
+			Put<int16>(Scratch, (int16)Delta.X);
+			Put<int16>(Scratch, (int16)Delta.Y);
+			Put<int16>(Scratch, (int16)Delta.Z);
+		}
+		if (Mask & RecordYaw) Put<uint16>(Scratch, Now.Yaw);
+		NumRecords++;
+	}
+	Scratch[RecordCountAt] = NumRecords;
+
+	Put<uint8>(Scratch, (uint8)PendingEvents.Num());
+	for (const FEvent& Event : PendingEvents)
+	{
+		Put<uint8>(Scratch, (uint8)Event.Type);
+		Put<uint8>(Scratch, Event.InstigatorSlot);
+		Put<uint8>(Scratch, Event.VictimSlot);
+		Put<int32>(Scratch, Event.Location.X);
+		Put<int32>(Scratch, Event.Location.Y);
+		Put<int32>(Scratch, Event.Location.Z);
+		for (int8 Component : Event.Normal) Put<int8>(Scratch, Component);
+	}
+	PendingEvents.Reset();
+
+	WriteFrame(Time, Keyframe);
+}
+
+void AScavengerKillCam::WriteFrame(float Time, bool Keyframe)
+{
+	const int32 Size = Scratch.Num();
+
+	// Snapshots are stored whole. When one won't fit before the end, everything between the
+	// write head and the end is older than anything at the front, so that goes first.
+	if (WriteOffset + Size > Buffer.Num())
+	{
+		while (NumFrames > 0 && GetFrame(0).Offset >= WriteOffset) DropOldestFrame();
+		WriteOffset = 0;
+	}
+
+	while (NumFrames > 0)
+	{
+		const FFrame& Oldest = GetFrame(0);
+		const bool Overlaps = Oldest.Offset < WriteOffset + Size && Oldest.Offset + Oldest.Size > WriteOffset;
+		if (!Overlaps && NumFrames < Frames.Num()) break;
+		DropOldestFrame();
+	}
+
+	FMemory::Memcpy(Buffer.GetData() + WriteOffset, Scratch.GetData(), Size);
+
+	FFrame& Frame = Frames[(FirstFrame + NumFrames) % Frames.Num()];
+	Frame.Offset = WriteOffset;
+	Frame.Size = Size;
+	Frame.Time = Time;
+	Frame.Keyframe = Keyframe;
+	NumFrames++;
+
+	WriteOffset += Size;
+}
+
+void AScavengerKillCam::DropOldestFrame()
+{
+	FirstFrame = (FirstFrame + 1) % Frames.Num();
+	NumFrames--;
+}
+
+void AScavengerKillCam::DecodeFrame(int32 Index, TArray<FSlotState>& State, TArray<FEvent>& OutEvents) const
+{
+	const uint8* Cursor = Buffer.GetData() + GetFrame(Index).Offset;
+
+	const uint8 FrameFlags = Take<uint8>(Cursor);
+	Take<float>(Cursor);
+
+	// A keyframe lists everyone there is, anyone it leaves out isn't around
+	if (FrameFlags & FrameKeyframe)
+	{
+		for (FSlotState& Slot : State) Slot.Valid = false;
+	}
+
+	const uint8 NumRecords = Take<uint8>(Cursor);
+	for (int32 i = 0; i < NumRecords; i++)
+	{
+		const uint8 SlotIndex = Take<uint8>(Cursor);
+		const uint8 Mask = Take<uint8>(Cursor);
+		FSlotState& Slot = State[SlotIndex];
+
+		if (Mask & RecordGone)
+		{
+			Slot.Valid = false;
+			continue;
+		}
+
+		if (Mask & RecordPositionFull)
+		{
+			Slot.Position.X = Take<int32>(Cursor);
+			Slot.Position.Y = Take<int32>(Cursor);
+			Slot.Position.Z = Take<int32>(Cursor);
+		}
+		else if (Mask & RecordPositionDelta)
+		{
+			Slot.Position.X += Take<int16>(Cursor);
+			Slot.Position.Y += Take<int16>(Cursor);
+			Slot.Position.Z += Take<int16>(Cursor);
+		}
+		if (Mask & RecordYaw) Slot.Yaw = Take<uint16>(Cursor);
+		Slot.Valid = true;
+	}
+
+	OutEvents.Reset();
+	const uint8 NumEvents = Take<uint8>(Cursor);
+	for (int32 i = 0; i < NumEvents; i++)
+	{
+		FEvent Event;
+		Event.Type = (EScavengerCombatEventType)Take<uint8>(Cursor);
+		Event.InstigatorSlot = Take<uint8>(Cursor);
+		Event.VictimSlot = Take<uint8>(Cursor);
+		Event.Location.X = Take<int32>(Cursor);
+		Event.Location.Y = Take<int32>(Cursor);
+		Event.Location.Z = Take<int32>(Cursor);
+		for (int8& Component : Event.Normal) Component = Take<int8>(Cursor);
+		OutEvents.Add(Event);
+	}
+}
+
+void AScavengerKillCam::StartPlayback(AActor* Killer)
+{
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (Playing || NumFrames == 0 || !PC) return;
+
+	// Start from the last keyframe before the window opens, or the oldest one left if the buffer is short
+	const float EndTime = GetFrame(NumFrames - 1).Time;
+	const float StartTime = EndTime - PlaybackDuration;
+	int32 Start = INDEX_NONE;
+	for (int32 i = 0; i < NumFrames; i++)
+	{
+		const FFrame& Frame = GetFrame(i);
+		if (!Frame.Keyframe) continue;
+		if (Start != INDEX_NONE && Frame.Time > StartTime) break;
+		Start = i;
+	}
+	if (Start == INDEX_NONE) return;
+
+	DecodeFrame(Start, NextState, NextEvents);
+	for (int32 i = 0; i < NextState.Num(); i++) PrevState[i] = NextState[i];
+	PrevTime = NextTime = GetFrame(Start).Time;
+	PlaybackTime = PrevTime;
+	PlaybackCursor = Start + 1;
+	KillerSlot = FindSlot(Killer);
+	VictimSlot = FindSlot(PC->GetPawn());
+
+	for (int32 i = 0; i < Slots.Num(); i++)
+	{
+		if (!Slots[i].Mesh) continue;
+
+		if (!Ghosts[i])
+		{
+			Ghosts[i] = NewObject<USkeletalMeshComponent>(this);
+			Ghosts[i]->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Ghosts[i]->RegisterComponent();
+		}
+		Ghosts[i]->SetSkeletalMesh(Slots[i].Mesh);
+		Ghosts[i]->EmptyOverrideMaterials();
+		for (int32 Material = 0; Material < Slots[i].Materials.Num(); Material++)
+		{
+			if (Slots[i].Materials[Material]) Ghosts[i]->SetMaterial(Material, Slots[i].Materials[Material]);
+		}
+		Ghosts[i]->SetAnimInstanceClass(Slots[i].AnimClass);
+	}
+
+	if (!Camera)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		Camera = GetWorld()->SpawnActor<ACameraActor>(SpawnParams);
+	}
+
+	Playing = true;
+	SetLiveCharactersHidden(true);
+	UpdatePlayback(0.0f);
+	if (Camera) PC->SetViewTarget(Camera);
+}
+
+void AScavengerKillCam::StopPlayback()
+{
+	if (!Playing) return;
+	Playing = false;
+
+	for (USkeletalMeshComponent* Ghost : Ghosts)
+	{
+		if (Ghost) Ghost->SetVisibility(false);
+	}
+	SetLiveCharactersHidden(false);
+
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (PC) PC->SetViewTarget(PC->GetPawn() ? (AActor*)PC->GetPawn() : PC);
+
+	// Recording paused for playback, so the next snapshot has nothing to take a delta from
+	FramesSinceKeyframe = 0;
+	RecordAccumulator = 0.0f;
+	PendingEvents.Reset();
+}
+
+void AScavengerKillCam::UpdatePlayback(float DeltaSeconds)
+{
+	PlaybackTime += DeltaSeconds;
+
+	// Events fire as their snapshot is decoded, at most one snapshot ahead of the ghosts
+	while (PlaybackTime >= NextTime)
+	{
+		if (PlaybackCursor >= NumFrames)
+		{
+			if (PlaybackTime >= NextTime + PlaybackHoldTime) StopPlayback();
+			break;
+		}
+
+		for (int32 i = 0; i < NextState.Num(); i++) PrevState[i] = NextState[i];
+		PrevTime = NextTime;
+		DecodeFrame(PlaybackCursor, NextState, NextEvents);
+		NextTime = GetFrame(PlaybackCursor).Time;
+		PlaybackCursor++;
+		PlayEvents(NextEvents);
+	}
+	if (!Playing) return;
+
+	const float Alpha = NextTime > PrevTime ? FMath::Clamp((PlaybackTime - PrevTime) / (NextTime - PrevTime), 0.0f, 1.0f) : 1.0f;
+
+	for (int32 i = 0; i < Ghosts.Num(); i++)
+	{
+		USkeletalMeshComponent* Ghost = Ghosts[i];
+		if (!Ghost) continue;
+
+		const FSlotState& Prev = PrevState[i];
+		const FSlotState& Next = NextState[i];
+		Ghost->SetVisibility(Next.Valid);
+		if (!Next.Valid) continue;
+
+		const FSlotState& From = Prev.Valid ? Prev : Next;
+		const FVector Location = FMath::Lerp(FVector(From.Position), FVector(Next.Position), Alpha);
+		// The short way round, a turn across 180 degrees mustn't spin the ghost the long way
+		const FQuat Rotation = FQuat::Slerp(
+			FRotator(0.0f, FRotator::DecompressAxisFromShort(From.Yaw), 0.0f).Quaternion(),
+			FRotator(0.0f, FRotator::DecompressAxisFromShort(Next.Yaw), 0.0f).Quaternion(),
+			Alpha);
+		Ghost->SetWorldTransform(Slots[i].MeshOffset * FTransform(Rotation, Location));
+	}
+
+	UpdateCamera(Alpha);
+}
+
+void AScavengerKillCam::UpdateCamera(float Alpha)
+{
+	if (!Camera) return;
+
+	auto SlotLocation = [&](int32 Slot, FVector& OutLocation, float& OutYaw) -> bool
+	{
+		if (Slot == INDEX_NONE || !NextState[Slot].Valid) return false;
+		const FSlotState& From = PrevState[Slot].Valid ? PrevState[Slot] : NextState[Slot];
+		OutLocation = FMath::Lerp(FVector(From.Position), FVector(NextState[Slot].Position), Alpha);
+		OutYaw = FRotator::DecompressAxisFromShort(NextState[Slot].Yaw);
+		return true;
+	};
+
+	FVector KillerLocation, VictimLocation;
+	float KillerYaw = 0.0f, VictimYaw = 0.0f;
+	const bool HaveKiller = SlotLocation(KillerSlot, KillerLocation, KillerYaw);
+	const bool HaveVictim = SlotLocation(VictimSlot, VictimLocation, VictimYaw);
+
+	FVector CameraLocation;
+	FVector LookAt;
+	if (HaveKiller)
+	{
+		// Over the killer's shoulder, watching the victim
+		CameraLocation = KillerLocation + FRotator(0.0f, KillerYaw, 0.0f).RotateVector(CameraOffset);
+		LookAt = HaveVictim ? VictimLocation : KillerLocation + FRotator(0.0f, KillerYaw, 0.0f).Vector() * 1000.0f;
+	}
+	else if (HaveVictim)
+	{
+		// Nobody to follow, circle the victim
+		CameraLocation = VictimLocation + FRotator(0.0f, PlaybackTime * 30.0f, 0.0f).RotateVector(FVector(-400.0f, 0.0f, 200.0f));
+		LookAt = VictimLocation;
+	}
+	else return;
+
+	Camera->SetActorLocationAndRotation(CameraLocation, (LookAt - CameraLocation).Rotation());
+}
+
+void AScavengerKillCam::PlayEvents(const TArray<FEvent>& Events)
+{
+	AScavengerEffectManager* Effects = AScavengerEffectManager::Get(GetWorld());
+	if (!Effects) return;
+
+	for (const FEvent& Event : Events)
+	{
+		const FRotator Rotation = FVector(Event.Normal[0], Event.Normal[1], Event.Normal[2]).Rotation();
+		if (Event.Type == EScavengerCombatEventType::Hit) Effects->RequestEffect(TEXT("Hit"), FVector(Event.Location), Rotation);
+		else if (Event.Type == EScavengerCombatEventType::Impact) Effects->RequestEffect(TEXT("Impact"), FVector(Event.Location), Rotation);
+	}
+}
+
+void AScavengerKillCam::SetLiveCharactersHidden(bool Hidden)
+{
+	for (const FSlot& Slot : Slots)
+	{
+		AScavengerCharacter* Character = Slot.Character.Get();
+		if (!Character) continue;
+
+		// Hides the held weapon with it
+		Character->SetActorHiddenInGame(Hidden);
+	}
+}
+
+SIZE_T AScavengerKillCam::GetResourceSize(EResourceSizeMode::Type Mode)
+{
+	// Recording buffers aren't properties, so the object's own serialization doesn't see them
+	return Super::GetResourceSize(Mode) + Slots.GetAllocatedSize() + Buffer.GetAllocatedSize() + Frames.GetAllocatedSize()
+		+ Scratch.GetAllocatedSize() + PendingEvents.GetAllocatedSize() + PrevState.GetAllocatedSize() + NextState.GetAllocatedSize()
+		+ NextEvents.GetAllocatedSize();
+}
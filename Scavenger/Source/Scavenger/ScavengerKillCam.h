@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ScavengerCombatListener.h"
+#include "ScavengerKillCam.generated.h"
+
+class AScavengerCharacter;
+
+/**
+ * Client-side kill-cam. Records the last few seconds of every character's position and facing
+ * plus combat events into a fixed-size byte ring
+ * buffer as delta-encoded snapshots, with a full keyframe every few snapshots. When the local
+ * player is killed the buffer is played back through ghost meshes with a camera over the killer.
+ * Recording allocates nothing after startup and each snapshot costs at most one record per character.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class SCAVENGER_API AScavengerKillCam : public AScavengerCombatListener
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerKillCam();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual SIZE_T GetResourceSize(EResourceSizeMode::Type Mode) override;
+
+	// Finds or spawns the kill-cam for World. Always null on dedicated servers.
+	static AScavengerKillCam* Get(UWorld* World);
+
+	// Starts recording Character, ignored once every slot is taken. Tracking it again picks up a
+	// new mesh or skin for its ghost.
+	void Track(AScavengerCharacter* Character);
+
+	void StartPlayback(AActor* Killer);
+	void StopPlayback();
+	bool IsPlaying() const { return Playing; }
+
+private:
+	// Quantized state of one character as recorded
+	struct FSlotState
+	{
+		FIntVector Position = FIntVector::ZeroValue;
+		uint16 Yaw = 0;
+		bool Valid = false;
+	};
+
+	struct FSlot
+	{
+		TWeakObjectPtr<AScavengerCharacter> Character;
+		USkeletalMesh* Mesh = nullptr;
+		TArray<UMaterialInterface*> Materials;
+		UClass* AnimClass = nullptr;
+		FTransform MeshOffset;
+		// Last state written, what the next delta is taken against
+		FSlotState Recorded;
+	};
+
+	struct FEvent
+	{
+		EScavengerCombatEventType Type = EScavengerCombatEventType::Hit;
+		uint8 InstigatorSlot = 0xFF;
+		uint8 VictimSlot = 0xFF;
+		FIntVector Location = FIntVector::ZeroValue;
+		// Normal in 1/127 steps
+		int8 Normal[3] = { 0, 0, 127 };
+	};
+
+	struct FFrame
+	{
+		int32 Offset = 0;
+		int32 Size = 0;
+		float Time = 0.0f;
+		bool Keyframe = false;
+	};
+
+	virtual void HandleCombatEvent(const FScavengerCombatEvent& Event) override;
+
+	int32 FindSlot(const AActor* Actor) const;
+
+	FSlotState Quantize(const AScavengerCharacter* Character) const;
+	void RecordFrame(float Time);
+	void WriteFrame(float Time, bool Keyframe);
+	void DropOldestFrame();
+	const FFrame& GetFrame(int32 Index) const { return Frames[(FirstFrame + Index) % Frames.Num()]; }
+
+	// Decodes logical frame Index over State and collects its events
+	void DecodeFrame(int32 Index, TArray<FSlotState>& State, TArray<FEvent>& OutEvents) const;
+
+	void UpdatePlayback(float DeltaSeconds);
+	void UpdateCamera(float Alpha);
+	void PlayEvents(const TArray<FEvent>& Events);
+	void SetLiveCharactersHidden(bool Hidden);
+
+	// Most bytes the ring buffer may hold, fixed for the session
+	UPROPERTY(Config)
+	int32 MemoryBudget = 65536;
+
+	// Snapshots per second
+	UPROPERTY(Config)
+	float RecordRate = 20.0f;
+
+	// Every this many snapshots carries full state, where playback can start from
+	UPROPERTY(Config)
+	int32 KeyframeInterval = 10;
+
+	// Seconds played back before the death
+	UPROPERTY(Config)
+	float PlaybackDuration = 4.0f;
+
+	UPROPERTY(Config)
+	int32 MaxTrackedCharacters = 16;
+
+	// Combat events kept per snapshot, extras are dropped
+	UPROPERTY(Config)
+	int32 MaxEventsPerFrame = 8;
+
+	// Camera placement behind the killer during playback
+	UPROPERTY(Config)
+	FVector CameraOffset = FVector(-250.0f, 60.0f, 90.0f);
+
+	TArray<FSlot> Slots;
+
+	// Encoded snapshots, and where each one sits in them
+	TArray<uint8> Buffer;
+	TArray<FFrame> Frames;
+	int32 FirstFrame = 0;
+	int32 NumFrames = 0;
+	int32 WriteOffset = 0;
+
+	// Snapshot being built, and events waiting for the next one
+	TArray<uint8> Scratch;
+	TArray<FEvent> PendingEvents;
+	int32 FramesSinceKeyframe = 0;
+	float RecordAccumulator = 0.0f;
+
+	bool Playing = false;
+	float PlaybackTime = 0.0f;
+	int32 PlaybackCursor = 0;
+	int32 KillerSlot = INDEX_NONE;
+	int32 VictimSlot = INDEX_NONE;
+	float PrevTime = 0.0f;
+	float NextTime = 0.0f;
+	TArray<FSlotState> PrevState;
+	TArray<FSlotState> NextState;
+	TArray<FEvent> NextEvents;
+
+	UPROPERTY(Transient)
+	TArray<USkeletalMeshComponent*> Ghosts;
+
+	UPROPERTY(Transient)
+	class ACameraActor* Camera;
+};
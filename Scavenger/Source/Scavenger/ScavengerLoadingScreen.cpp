@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerLoadingScreen.h"
+#include "SThrobber.h"
+
+void SScavengerLoadingScreen::Construct(const FArguments& InArgs)
+{
+	ChildSlot
+	[
+		SNew(SBorder)
+		.BorderImage(FCoreStyle::Get().GetBrush("WhiteBrush"))
+		.BorderBackgroundColor(FLinearColor::Black)
+		.Padding(FMargin(48.0f))
+		[
+			// Bottom right, out of the way of whatever the last frame left on screen
+			SNew(SVerticalBox)
+			+ SVerticalBox::Slot()
+			.FillHeight(1.0f)
+			.HAlign(HAlign_Right)
+			.VAlign(VAlign_Bottom)
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.VAlign(VAlign_Center)
+				.Padding(FMargin(0.0f, 0.0f, 16.0f, 0.0f))
+				[
+					SNew(STextBlock)
+					.Text(InArgs._Message)
+					.Font(FCoreStyle::GetDefaultFontStyle("Regular", 24))
+					.ColorAndOpacity(FLinearColor::White)
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.VAlign(VAlign_Center)
+				[
+					SNew(SCircularThrobber)
+					.Radius(16.0f)
+				]
+			]
+		]
+	];
+}
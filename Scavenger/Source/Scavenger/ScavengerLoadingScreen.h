@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SlateBasics.h"
+
+/**
+ * Drawn by the movie player on its own thread while a map loads, so it must not touch
+ * UObjects: everything it shows is copied in when it is built.
+ */
+class SScavengerLoadingScreen : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SScavengerLoadingScreen)
+		{}
+		SLATE_ARGUMENT(FText, Message)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+};
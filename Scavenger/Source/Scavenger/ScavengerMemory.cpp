@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerMemory.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerWeaponComponent.h"
+#include "CollidableCoverComponent.h"
+#include "ScavengerCorpseManager.h"
+#include "ScavengerEffectManager.h"
+#include "ScavengerGameState.h"
+#include "ScavengerKillCam.h"
+#include "ScavengerProjectileManager.h"
+#include "EngineUtils.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Engine/Channel.h"
+
+FThreadSafeCounter64 FScavengerMemory::Tracked[(int32)EScavengerMemoryCategory::Count];
+
+// Shortest gap between memory CSV rows, in seconds
+static const float MinMemoryCsvInterval = 1.0f;
+
+namespace ScavengerMemory
+{
+	// Native classes of this module, Blueprint subclasses are judged by their native parent
+	static bool IsScavengerClass(const UClass* Class)
+	{
+		while (Class && !Class->HasAnyClassFlags(CLASS_Native)) Class = Class->GetSuperClass();
+
+		static const FName ModulePackage(TEXT("/Script/Scavenger"));
+		return Class && Class->GetOutermost()->GetFName() == ModulePackage;
+	}
+
+	static EScavengerMemoryCategory GetActorCategory(const AActor* Actor)
+	{
+		if (Actor->IsA<AScavengerCharacter>()) return EScavengerMemoryCategory::Characters;
+		if (Actor->IsA<AScavengerGameState>()) return EScavengerMemoryCategory::Replication;
+		if (Actor->IsA<AScavengerEffectManager>() || Actor->IsA<AScavengerProjectileManager>()
+			|| Actor->IsA<AScavengerCorpseManager>() || Actor->IsA<AScavengerKillCam>())
+		{
+			return EScavengerMemoryCategory::Effects;
+		}
+		return EScavengerMemoryCategory::Other;
+	}
+
+	// Adds Object to Stats and returns what it was measured at
+	static int64 Measure(UObject* Object, FScavengerMemoryCategoryStats& Stats)
+	{
+		FArchiveCountMem Count(Object);
+		const int64 ObjectBytes = Count.GetMax();
+		const int64 NativeBytes = Object->GetResourceSize(EResourceSizeMode::Exclusive);
+
+		Stats.Instances++;
+		Stats.ObjectBytes += ObjectBytes;
+		Stats.NativeBytes += NativeBytes;
+		return ObjectBytes + NativeBytes;
+	}
+
+	static void MeasureConnection(UNetConnection* Connection, FScavengerMemoryCategoryStats& Stats)
+	{
+		if (!Connection) return;
+
+		Measure(Connection, Stats);
+		for (UChannel* Channel : Connection->OpenChannels)
+		{
+			if (Channel) Measure(Channel, Stats);
+		}
+	}
+
+	static void ReportCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		FScavengerMemory::Report(World);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ReportConsoleCommand(
+		TEXT("scav.Memory"),
+		TEXT("Logs memory used by Scavenger gameplay code, by category and per character."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ReportCommand));
+}
+
+using namespace ScavengerMemory;
+
+int64 FScavengerMemorySnapshot::GetTotal() const
+{
+	int64 Total = 0;
+	for (const FScavengerMemoryCategoryStats& Category : Categories) Total += Category.GetTotal();
+	return Total;
+}
+
+FScavengerMemorySnapshot FScavengerMemory::Gather(UWorld* World)
+{
+	FScavengerMemorySnapshot Snapshot;
+	auto Stats = [&Snapshot](EScavengerMemoryCategory Category) -> FScavengerMemoryCategoryStats& { return Snapshot.Categories[(int32)Category]; };
+
+	for (int32 i = 0; i < (int32)EScavengerMemoryCategory::Count; i++)
+	{
+		Snapshot.Categories[i].TrackedBytes = Tracked[i].GetValue();
+	}
+	Snapshot.ResidentBytes = FPlatformMemory::GetStats().UsedPhysical;
+
+	if (!World) return Snapshot;
+
+	if (World->GameState) Snapshot.Players = World->GameState->PlayerArray.Num();
+
+	int64 CharacterBytesSum = 0;
+	for (FActorIterator It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+		const bool ScavengerActor = IsScavengerClass(Actor->GetClass());
+		const EScavengerMemoryCategory ActorCategory = GetActorCategory(Actor);
+
+		AScavengerCharacter* Character = Cast<AScavengerCharacter>(Actor);
+		int64 CharacterBytes = 0;
+
+		if (ScavengerActor) CharacterBytes += Measure(Actor, Stats(ActorCategory));
+
+		TInlineComponentArray<UActorComponent*> Components;
+		Actor->GetComponents(Components);
+		for (UActorComponent* Component : Components)
+		{
+			// Module components count wherever they are, engine components only on module actors
+			EScavengerMemoryCategory Category = ActorCategory;
+			if (Component->IsA<UScavengerWeaponComponent>() || (Character && Character->Weapon && Component == Character->Weapon->GetMesh())) Category = EScavengerMemoryCategory::Weapons;
+			else if (Component->IsA<UCollidableCoverComponent>()) Category = EScavengerMemoryCategory::Cover;
+			else if (!ScavengerActor) continue;
+
+			CharacterBytes += Measure(Component, Stats(Category));
+		}
+
+		if (Character)
+		{
+			UAnimInstance* AnimInstance = Character->GetMesh() ? Character->GetMesh()->GetAnimInstance() : nullptr;
+			if (AnimInstance) CharacterBytes += Measure(AnimInstance, Stats(EScavengerMemoryCategory::Characters));
+
+			Snapshot.Characters++;
+			CharacterBytesSum += CharacterBytes;
+			Snapshot.CharacterMaxBytes = FMath::Max(Snapshot.CharacterMaxBytes, CharacterBytes);
+		}
+	}
+	if (Snapshot.Characters) Snapshot.CharacterAverageBytes = CharacterBytesSum / Snapshot.Characters;
+
+	UNetDriver* NetDriver = World->GetNetDriver();
+	if (NetDriver)
+	{
+		FScavengerMemoryCategoryStats& Replication = Stats(EScavengerMemoryCategory::Replication);
+		Measure(NetDriver, Replication);
+		MeasureConnection(NetDriver->ServerConnection, Replication);
+		for (UNetConnection* Connection : NetDriver->ClientConnections) MeasureConnection(Connection, Replication);
+	}
+
+	return Snapshot;
+}
+
+void FScavengerMemory::Report(UWorld* World)
+{
+	const FScavengerMemorySnapshot Snapshot = Gather(World);
+
+	UE_LOG(LogScavenger, Log, TEXT("Scavenger memory: %.1f KB total, %d players, %d characters at %.1f KB average (%.1f KB max), process resident %.1f MB"),
+		Snapshot.GetTotal() / 1024.0, Snapshot.Players, Snapshot.Characters,
+		Snapshot.CharacterAverageBytes / 1024.0, Snapshot.CharacterMaxBytes / 1024.0, Snapshot.ResidentBytes / 1048576.0);
+	UE_LOG(LogScavenger, Log, TEXT("  %-12s %9s %11s %11s %11s %11s"), TEXT("Category"), TEXT("Instances"), TEXT("Object KB"), TEXT("Native KB"), TEXT("Tracked KB"), TEXT("Total KB"));
+
+	for (int32 i = 0; i < (int32)EScavengerMemoryCategory::Count; i++)
+	{
+		const FScavengerMemoryCategoryStats& Category = Snapshot.Categories[i];
+		UE_LOG(LogScavenger, Log, TEXT("  %-12s %9d %11.1f %11.1f %11.1f %11.1f"), GetCategoryName((EScavengerMemoryCategory)i), Category.Instances,
+			Category.ObjectBytes / 1024.0, Category.NativeBytes / 1024.0, Category.TrackedBytes / 1024.0, Category.GetTotal() / 1024.0);
+	}
+}
+
+const TCHAR* FScavengerMemory::GetCategoryName(EScavengerMemoryCategory Category)
+{
+	switch (Category)
+	{
+	case EScavengerMemoryCategory::Characters: return TEXT("Characters");
+	case EScavengerMemoryCategory::Weapons: return TEXT("Weapons");
+	case EScavengerMemoryCategory::Cover: return TEXT("Cover");
+	case EScavengerMemoryCategory::Replication: return TEXT("Replication");
+	case EScavengerMemoryCategory::Effects: return TEXT("Effects");
+	case EScavengerMemoryCategory::Diagnostics: return TEXT("Diagnostics");
+	case EScavengerMemoryCategory::Other: return TEXT("Other");
+	default: return TEXT("Unknown");
+	}
+}
+
+FScavengerMemoryCsv::FScavengerMemoryCsv(UGameInstance* InGameInstance)
+	: GameInstance(InGameInstance)
+{
+}
+
+FScavengerMemoryCsv::~FScavengerMemoryCsv()
+{
+	if (TickerHandle.IsValid()) FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	if (Writer)
+	{
+		Writer->Close();
+		delete Writer;
+	}
+}
+
+bool FScavengerMemoryCsv::Start(float Interval)
+{
+	const FString Path = FPaths::ProfilingDir() / TEXT("ScavengerMemory") / FString::Printf(TEXT("%s.csv"), *FDateTime::Now().ToString());
+	Writer = IFileManager::Get().CreateFileWriter(*Path, FILEWRITE_AllowRead);
+	if (!Writer)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Couldn't write memory samples to %s"), *Path);
+		return false;
+	}
+
+	FString Header = TEXT("Seconds,Players,Characters,CharacterAverageBytes,CharacterMaxBytes");
+	for (int32 i = 0; i < (int32)EScavengerMemoryCategory::Count; i++)
+	{
+		Header += FString::Printf(TEXT(",%sInstances,%sBytes"), FScavengerMemory::GetCategoryName((EScavengerMemoryCategory)i), FScavengerMemory::GetCategoryName((EScavengerMemoryCategory)i));
+	}
+	Header += TEXT(",TotalBytes,ResidentBytes\n");
+
+	FTCHARToUTF8 HeaderUtf8(*Header);
+	Writer->Serialize((void*)HeaderUtf8.Get(), HeaderUtf8.Length());
+	Writer->Flush();
+
+	// A sample walks every actor and component, any more often and it shows in the frame time
+	if (Interval < MinMemoryCsvInterval)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("MemoryCsvInterval %.2fs is below the %.0fs minimum, using %.0fs"), Interval, MinMemoryCsvInterval, MinMemoryCsvInterval);
+		Interval = MinMemoryCsvInterval;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FScavengerMemoryCsv::Tick), Interval);
+
+	UE_LOG(LogScavenger, Log, TEXT("Writing memory samples every %.0fs to %s"), Interval, *Path);
+	return true;
+}
+
+bool FScavengerMemoryCsv::Tick(float DeltaTime)
+{
+	UGameInstance* Instance = GameInstance.Get();
+	const FScavengerMemorySnapshot Snapshot = FScavengerMemory::Gather(Instance ? Instance->GetWorld() : nullptr);
+
+	FString Row = FString::Printf(TEXT("%.1f,%d,%d,%lld,%lld"), FPlatformTime::Seconds() - StartTime,
+		Snapshot.Players, Snapshot.Characters, Snapshot.CharacterAverageBytes, Snapshot.CharacterMaxBytes);
+	for (const FScavengerMemoryCategoryStats& Category : Snapshot.Categories)
+	{
+		Row += FString::Printf(TEXT(",%d,%lld"), Category.Instances, Category.GetTotal());
+	}
+	Row += FString::Printf(TEXT(",%lld,%llu\n"), Snapshot.GetTotal(), Snapshot.ResidentBytes);
+
+	FTCHARToUTF8 RowUtf8(*Row);
+	Writer->Serialize((void*)RowUtf8.Get(), RowUtf8.Length());
+	Writer->Flush();
+	return true;
+}
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Containers/Ticker.h"
+
+// What gameplay memory is charged to
+enum class EScavengerMemoryCategory : uint8
+{
+	// Characters, their engine components and anim instances
+	Characters,
+	// Weapon components and the meshes instanced from weapon templates
+	Weapons,
+	// Cover components on level geometry
+	Cover,
+	// Net driver, connections and channels, and the game state's combat feed
+	Replication,
+	// Effect, projectile, corpse and kill-cam managers with their pooled components
+	Effects,
+	// Trace buffers and other instrumentation
+	Diagnostics,
+	// Any other Scavenger actor (game mode, HUD)
+	Other,
+	Count
+};
+
+struct FScavengerMemoryCategoryStats
+{
+	int32 Instances = 0;
+	// Object memory as counted by serialization
+	int64 ObjectBytes = 0;
+	// Native buffers the objects report through GetResourceSize
+	int64 NativeBytes = 0;
+	// Allocations outside any object, reported through FScavengerMemory::Track
+	int64 TrackedBytes = 0;
+
+	int64 GetTotal() const { return ObjectBytes + NativeBytes + TrackedBytes; }
+};
+
+struct FScavengerMemorySnapshot
+{
+	FScavengerMemoryCategoryStats Categories[(int32)EScavengerMemoryCategory::Count];
+
+	int32 Players = 0;
+	int32 Characters = 0;
+	// One character with its components, weapon and anim instance
+	int64 CharacterAverageBytes = 0;
+	int64 CharacterMaxBytes = 0;
+
+	uint64 ResidentBytes = 0;
+
+	int64 GetTotal() const;
+};
+
+/**
+ * Memory used by the Scavenger module, by category. Objects are measured on demand by walking the
+ * world's actors: anything whose native class lives in this module is counted, along with this
+ * module's components on any actor. Object sizes come from FArchiveCountMem plus GetResourceSize for
+ * native buffers that aren't properties; allocations that belong to no object are reported through
+ * Track. Gathering walks every actor, so it's meant for a console command or a slow periodic dump,
+ * not every frame.
+ */
+struct SCAVENGER_API FScavengerMemory
+{
+	// Adds Bytes (negative to release) to Category's tracked total. Any thread.
+	static void Track(EScavengerMemoryCategory Category, int64 Bytes)
+	{
+		Tracked[(int32)Category].Add(Bytes);
+	}
+
+	static FScavengerMemorySnapshot Gather(UWorld* World);
+
+	// Logs Gather for World by category
+	static void Report(UWorld* World);
+
+	static const TCHAR* GetCategoryName(EScavengerMemoryCategory Category);
+
+private:
+	static FThreadSafeCounter64 Tracked[(int32)EScavengerMemoryCategory::Count];
+};
+
+/**
+ * Appends a snapshot of a game instance's world to a CSV file in Saved/Profiling every interval,
+ * one row per sample, so growth with player count and leaks across matches show up as trends.
+ */
+class FScavengerMemoryCsv
+{
+public:
+	explicit FScavengerMemoryCsv(UGameInstance* InGameInstance);
+	~FScavengerMemoryCsv();
+
+	// Opens the file and starts sampling every Interval seconds, at least 1. False if the file couldn't be created.
+	bool Start(float Interval);
+
+private:
+	bool Tick(float DeltaTime);
+
+	TWeakObjectPtr<UGameInstance> GameInstance;
+	FDelegateHandle TickerHandle;
+	FArchive* Writer = nullptr;
+	double StartTime = 0.0;
+};
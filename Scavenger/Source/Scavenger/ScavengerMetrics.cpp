@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerMetrics.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerStats.h"
+#include "EngineUtils.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/GameState.h"
+#include "GameFramework/PlayerState.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+const double FScavengerMetrics::FrameBucketBounds[FScavengerMetrics::NumFrameBuckets] =
+{
+	0.005, 0.010, 0.0167, 0.025, 0.0333, 0.050, 0.100, 0.250
+};
+
+// Accepts scrapes one at a time and answers each with the last published page
+class FScavengerMetricsServer : public FRunnable
+{
+public:
+	bool Listen(const FString& BindAddress, int32 Port)
+	{
+		ISocketSubsystem* Sockets = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+		if (!Sockets) return false;
+
+		TSharedRef<FInternetAddr> Address = Sockets->CreateInternetAddr();
+		bool ValidAddress = false;
+		Address->SetIp(*BindAddress, ValidAddress);
+		Address->SetPort(Port);
+		if (!ValidAddress) return false;
+
+		Listener = Sockets->CreateSocket(NAME_Stream, TEXT("ScavengerMetrics"), false);
+		if (!Listener) return false;
+
+		Listener->SetReuseAddr(true);
+		if (!Listener->Bind(*Address) || !Listener->Listen(8))
+		{
+			Sockets->DestroySocket(Listener);
+			Listener = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	void Publish(FString&& NewPage)
+	{
+		FScopeLock Lock(&PageLock);
+		Page = MoveTemp(NewPage);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (StopTaskCounter.GetValue() == 0)
+		{
+			// Wakes up regularly so Stop is noticed without a connection coming in
+			bool Pending = false;
+			if (!Listener->WaitForPendingConnection(Pending, FTimespan::FromMilliseconds(250)) || !Pending) continue;
+
+			FSocket* Client = Listener->Accept(TEXT("ScavengerMetricsScrape"));
+			if (!Client) continue;
+
+			Serve(*Client);
+			Client->Close();
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Client);
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		StopTaskCounter.Increment();
+	}
+
+	virtual ~FScavengerMetricsServer()
+	{
+		if (Listener)
+		{
+			Listener->Close();
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+		}
+	}
+
+private:
+	void Serve(FSocket& Client)
+	{
+		// The request line is all that matters, and it arrives in the first read
+		uint8 Request[1024];
+		int32 Read = 0;
+		if (!Client.Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(1.0)) || !Client.Recv(Request, sizeof(Request) - 1, Read) || Read <= 0) return;
+		Request[Read] = 0;
+
+		const FString RequestLine = FString(ANSI_TO_TCHAR((const ANSICHAR*)Request));
+		const bool Found = RequestLine.StartsWith(TEXT("GET /metrics ")) || RequestLine.StartsWith(TEXT("GET / "));
+
+		FString Body;
+		if (Found)
+		{
+			FScopeLock Lock(&PageLock);
+			Body = Page;
+		}
+		else
+		{
+			Body = TEXT("Not found, metrics are at /metrics\n");
+		}
+
+		FTCHARToUTF8 BodyUtf8(*Body);
+		const FString Headers = FString::Printf(TEXT("HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %d\r\nConnection: close\r\n\r\n"),
+			Found ? TEXT("200 OK") : TEXT("404 Not Found"), BodyUtf8.Length());
+		FTCHARToUTF8 HeadersUtf8(*Headers);
+
+		SendAll(Client, (const uint8*)HeadersUtf8.Get(), HeadersUtf8.Length());
+		SendAll(Client, (const uint8*)BodyUtf8.Get(), BodyUtf8.Length());
+	}
+
+	static void SendAll(FSocket& Client, const uint8* Data, int32 Size)
+	{
+		while (Size > 0)
+		{
+			int32 Sent = 0;
+			if (!Client.Send(Data, Size, Sent) || Sent <= 0) return;
+			Data += Sent;
+			Size -= Sent;
+		}
+	}
+
+	FSocket* Listener = nullptr;
+	FThreadSafeCounter StopTaskCounter;
+
+	FCriticalSection PageLock;
+	FString Page;
+};
+
+FScavengerMetrics::FScavengerMetrics(UGameInstance* InGameInstance)
+	: GameInstance(InGameInstance)
+{
+	FMemory::Memzero(FrameBuckets, sizeof(FrameBuckets));
+}
+
+FScavengerMetrics::~FScavengerMetrics()
+{
+	if (TickerHandle.IsValid()) FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	if (ServerThread)
+	{
+		ServerThread->Kill(true);
+		delete ServerThread;
+	}
+	delete Server;
+}
+
+bool FScavengerMetrics::Start(const FString& BindAddress, int32 Port, float InPublishInterval)
+{
+	PublishInterval = FMath::Max(InPublishInterval, 0.1f);
+
+	Server = new FScavengerMetricsServer;
+	if (!Server->Listen(BindAddress, Port))
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Couldn't listen for metrics scrapes on %s:%d"), *BindAddress, Port);
+		delete Server;
+		Server = nullptr;
+		return false;
+	}
+
+	Server->Publish(BuildPage());
+	ServerThread = FRunnableThread::Create(Server, TEXT("ScavengerMetrics"), 0, TPri_BelowNormal);
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FScavengerMetrics::Tick));
+
+	UE_LOG(LogScavenger, Log, TEXT("Serving metrics on http://%s:%d/metrics"), *BindAddress, Port);
+	return true;
+}
+
+bool FScavengerMetrics::Tick(float DeltaTime)
+{
+	int32 Bucket = 0;
+	while (Bucket < NumFrameBuckets && DeltaTime > FrameBucketBounds[Bucket]) Bucket++;
+	FrameBuckets[Bucket]++;
+	Frames++;
+	FrameSecondsSum += DeltaTime;
+
+	SampleCounters();
+
+	SincePublish += DeltaTime;
+	if (SincePublish >= PublishInterval)
+	{
+		SincePublish = 0.0f;
+
+		const uint64 IntervalFrames = Frames - FramesAtPublish;
+		TracesPerFrame = IntervalFrames > 0 ? (double)(Traces.Total - TracesAtPublish) / IntervalFrames : 0.0;
+		TracesAtPublish = Traces.Total;
+		FramesAtPublish = Frames;
+
+		Server->Publish(BuildPage());
+	}
+	return true;
+}
+
+void FScavengerMetrics::SampleCounters()
+{
+	Traces.Sample(FScavengerCounters::Traces.GetValue());
+	RpcBytes.Sample(FScavengerCounters::RpcBytes.GetValue());
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+	{
+		RpcCalls[i].Sample(FScavengerCounters::RpcCalls[i].GetValue());
+		RpcDropped[i].Sample(FScavengerCounters::RpcDropped[i].GetValue());
+	}
+}
+
+FString FScavengerMetrics::BuildPage() const
+{
+	FString Page;
+	Page.Reserve(4096);
+
+	// Frame time
+	Page += TEXT("# HELP scavenger_frame_seconds Engine frame time.\n# TYPE scavenger_frame_seconds histogram\n");
+	uint64 Cumulative = 0;
+	for (int32 i = 0; i < NumFrameBuckets; i++)
+	{
+		Cumulative += FrameBuckets[i];
+		Page += FString::Printf(TEXT("scavenger_frame_seconds_bucket{le=\"%g\"} %llu\n"), FrameBucketBounds[i], Cumulative);
+	}
+	Page += FString::Printf(TEXT("scavenger_frame_seconds_bucket{le=\"+Inf\"} %llu\n"), Frames);
+	Page += FString::Printf(TEXT("scavenger_frame_seconds_sum %f\nscavenger_frame_seconds_count %llu\n"), FrameSecondsSum, Frames);
+
+	// Hot-path counters
+	Page += TEXT("# HELP scavenger_traces_total Scene queries issued by gameplay code.\n# TYPE scavenger_traces_total counter\n");
+	Page += FString::Printf(TEXT("scavenger_traces_total %llu\n"), Traces.Total);
+	Page += TEXT("# HELP scavenger_traces_per_frame Scene queries per frame over the last publish interval.\n# TYPE scavenger_traces_per_frame gauge\n");
+	Page += FString::Printf(TEXT("scavenger_traces_per_frame %f\n"), TracesPerFrame);
+
+	Page += TEXT("# HELP scavenger_rpcs_total Character RPCs executed here, by type.\n# TYPE scavenger_rpcs_total counter\n");
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+	{
+		Page += FString::Printf(TEXT("scavenger_rpcs_total{rpc=\"%s\"} %llu\n"), FScavengerCounters::GetRpcName((EScavengerRpc)i), RpcCalls[i].Total);
+	}
+	Page += TEXT("# HELP scavenger_rpc_payload_bytes_total Approximate parameter bytes of executed RPCs.\n# TYPE scavenger_rpc_payload_bytes_total counter\n");
+	Page += FString::Printf(TEXT("scavenger_rpc_payload_bytes_total %llu\n"), RpcBytes.Total);
+	Page += TEXT("# HELP scavenger_rpcs_dropped_total Character RPCs dropped for going over their connection's budget, by type.\n# TYPE scavenger_rpcs_dropped_total counter\n");
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+	{
+		Page += FString::Printf(TEXT("scavenger_rpcs_dropped_total{rpc=\"%s\"} %llu\n"), FScavengerCounters::GetRpcName((EScavengerRpc)i), RpcDropped[i].Total);
+	}
+
+	// Process memory
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	Page += TEXT("# HELP scavenger_resident_memory_bytes Physical memory used by this process.\n# TYPE scavenger_resident_memory_bytes gauge\n");
+	Page += FString::Printf(TEXT("scavenger_resident_memory_bytes %llu\n"), (uint64)MemoryStats.UsedPhysical);
+	Page += TEXT("# HELP scavenger_resident_memory_peak_bytes Most physical memory this process has used.\n# TYPE scavenger_resident_memory_peak_bytes gauge\n");
+	Page += FString::Printf(TEXT("scavenger_resident_memory_peak_bytes %llu\n"), (uint64)MemoryStats.PeakUsedPhysical);
+
+	// World state
+	UGameInstance* Instance = GameInstance.Get();
+	UWorld* World = Instance ? Instance->GetWorld() : nullptr;
+
+	int32 Players = 0;
+	int32 Characters = 0;
+	int32 InCover = 0;
+	int32 Dashing = 0;
+	int32 Aiming = 0;
+	int32 Dead = 0;
+	if (World)
+	{
+		if (World->GameState) Players = World->GameState->PlayerArray.Num();
+
+		for (TActorIterator<AScavengerCharacter> It(World); It; ++It)
+		{
+			Characters++;
+			if (It->InCoverCPP) InCover++;
+			if (It->IsDashingCPP) Dashing++;
+			if (It->IsAimingCPP) Aiming++;
+			if (It->IsDeadCPP) Dead++;
+		}
+	}
+
+	Page += TEXT("# HELP scavenger_players Players in the match.\n# TYPE scavenger_players gauge\n");
+	Page += FString::Printf(TEXT("scavenger_players %d\n"), Players);
+	Page += TEXT("# HELP scavenger_characters Characters in the world, by state.\n# TYPE scavenger_characters gauge\n");
+	Page += FString::Printf(TEXT("scavenger_characters{state=\"all\"} %d\n"), Characters);
+	Page += FString::Printf(TEXT("scavenger_characters{state=\"in_cover\"} %d\n"), InCover);
+	Page += FString::Printf(TEXT("scavenger_characters{state=\"dashing\"} %d\n"), Dashing);
+	Page += FString::Printf(TEXT("scavenger_characters{state=\"aiming\"} %d\n"), Aiming);
+	Page += FString::Printf(TEXT("scavenger_characters{state=\"dead\"} %d\n"), Dead);
+
+	// Per-connection traffic, over the connection's last stat period. Series are keyed by remote address,
+	// which every connection has; player is empty until the connection has a PlayerState.
+	UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	auto AddConnectionFamily = [&](const TCHAR* Name, const TCHAR* Help, int32 UNetConnection::*Value)
+	{
+		Page += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s gauge\n"), Name, Help, Name);
+		if (!NetDriver) return;
+
+		for (UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (!Connection) continue;
+
+			APlayerController* PC = Connection->PlayerController;
+			const FString Player = PC && PC->PlayerState ? FString::FromInt(PC->PlayerState->PlayerId) : FString();
+			Page += FString::Printf(TEXT("%s{connection=\"%s\",player=\"%s\"} %d\n"),
+				Name, *Connection->LowLevelGetRemoteAddress(true), *Player, Connection->*Value);
+		}
+	};
+	AddConnectionFamily(TEXT("scavenger_connection_sent_bytes_per_second"), TEXT("Bytes sent to each client."), &UNetConnection::OutBytesPerSecond);
+	AddConnectionFamily(TEXT("scavenger_connection_received_bytes_per_second"), TEXT("Bytes received from each client."), &UNetConnection::InBytesPerSecond);
+
+	return Page;
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Containers/Ticker.h"
+#include "ScavengerStats.h"
+
+/**
+ * Live server metrics in Prometheus text exposition format, served over plain HTTP on a local port.
+ * Hot-path numbers are the lock-free FScavengerCounters; everything else (frame time histogram, memory,
+ * player and character counts, per-connection traffic) is gathered on the game thread once per
+ * publish interval into a finished page. A separate thread owns the socket and only ever hands out
+ * the latest page, so a slow or stuck scraper never touches the game thread.
+ */
+class FScavengerMetrics
+{
+public:
+	explicit FScavengerMetrics(UGameInstance* InGameInstance);
+	~FScavengerMetrics();
+
+	// Starts listening on BindAddress:Port, false if the socket couldn't be set up
+	bool Start(const FString& BindAddress, int32 Port, float InPublishInterval);
+
+private:
+	bool Tick(float DeltaTime);
+	void SampleCounters();
+	FString BuildPage() const;
+
+	// Upper bounds of the frame time histogram buckets, in seconds
+	static const int32 NumFrameBuckets = 8;
+	static const double FrameBucketBounds[NumFrameBuckets];
+
+	TWeakObjectPtr<UGameInstance> GameInstance;
+	FDelegateHandle TickerHandle;
+
+	class FScavengerMetricsServer* Server = nullptr;
+	FRunnableThread* ServerThread = nullptr;
+
+	// Game thread only. Cumulative, as Prometheus expects.
+	uint64 FrameBuckets[NumFrameBuckets + 1];
+	uint64 Frames = 0;
+	double FrameSecondsSum = 0.0;
+
+	// Counters since startup, sampled every frame
+	FScavengerCounterTotal Traces;
+	FScavengerCounterTotal RpcCalls[(int32)EScavengerRpc::Count];
+	FScavengerCounterTotal RpcBytes;
+	FScavengerCounterTotal RpcDropped[(int32)EScavengerRpc::Count];
+
+	// Traces per frame over the last publish interval
+	uint64 TracesAtPublish = 0;
+	uint64 FramesAtPublish = 0;
+	double TracesPerFrame = 0.0;
+
+	float PublishInterval = 1.0f;
+	float SincePublish = 0.0f;
+};
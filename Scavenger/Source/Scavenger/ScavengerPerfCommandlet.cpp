@@ -0,0 +1,373 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerPerfCommandlet.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerGameInstance.h"
+#include "ScavengerStats.h"
+#include "GameMapsSettings.h"
+#include "EngineUtils.h"
+#include "Engine/StaticMeshActor.h"
+#include "GameFramework/PlayerStart.h"
+
+// Same step the characters' frame-counted timers were tuned at
+static const float PerfFixedDeltaTime = 1.0f / 30.0f;
+
+// Frames ticked before recording so map load and first-spawn costs stay out of the numbers
+static const int32 PerfWarmupFrames = 30;
+
+// Metric names in the order they are reported and written
+static const TCHAR* PerfMetrics[] =
+{
+	TEXT("AvgFrameMs"),
+	TEXT("P95FrameMs"),
+	TEXT("TracesPerFrame"),
+	TEXT("PeakTracesPerFrame"),
+	TEXT("RpcsPerFrame"),
+	TEXT("RpcBytesPerFrame"),
+};
+
+static float DefaultTolerance(const FString& Metric)
+{
+	// Timings are noisy on shared build machines, the counts are deterministic
+	return Metric.EndsWith(TEXT("Ms")) ? 0.25f : 0.05f;
+}
+
+UScavengerPerfCommandlet::UScavengerPerfCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UScavengerPerfCommandlet::Main(const FString& Params)
+{
+	FString MapName = GetDefault<UGameMapsSettings>()->GetGameDefaultMap();
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	// The default map setting is an object path, /Game/Map.Map; everything below wants the package
+	MapName = FPackageName::ObjectPathToPackageName(MapName);
+
+	int32 NumCharacters = 8;
+	FParse::Value(*Params, TEXT("Characters="), NumCharacters);
+	NumCharacters = FMath::Max(NumCharacters, 1);
+
+	int32 NumFrames = 360;
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	NumFrames = FMath::Max(NumFrames, 1);
+
+	FString BaselinePath = FString::Printf(TEXT("Build/PerfBaselines/%s.txt"), *FPackageName::GetShortName(MapName));
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	if (FPaths::IsRelative(BaselinePath)) BaselinePath = FPaths::Combine(*FPaths::GameDir(), *BaselinePath);
+
+	const bool WriteBaseline = FParse::Param(*Params, TEXT("WriteBaseline"));
+
+	UWorld* World = LoadWorld(MapName);
+	if (!World) return 2;
+
+	SpawnScenario(World, NumCharacters);
+	if (Characters.Num() == 0)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("No characters could be spawned in %s"), *MapName);
+		return 2;
+	}
+
+	for (int32 Frame = 0; Frame < PerfWarmupFrames; Frame++)
+	{
+		World->Tick(LEVELTICK_All, PerfFixedDeltaTime);
+		GFrameCounter++;
+	}
+
+	TArray<float> FrameMs;
+	FrameMs.Reserve(NumFrames);
+	uint64 PeakTraces = 0;
+
+	// Counted from here, and sampled every frame so an editor session that wrapped a counter still adds up
+	FScavengerCounterTotal Traces;
+	FScavengerCounterTotal RpcBytes;
+	FScavengerCounterTotal RpcCalls[(int32)EScavengerRpc::Count];
+	Traces.Reset(FScavengerCounters::Traces.GetValue());
+	RpcBytes.Reset(FScavengerCounters::RpcBytes.GetValue());
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++) RpcCalls[i].Reset(FScavengerCounters::RpcCalls[i].GetValue());
+
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		const uint64 TracesBefore = Traces.Total;
+		const double FrameStart = FPlatformTime::Seconds();
+
+		DriveScenario(Frame);
+		World->Tick(LEVELTICK_All, PerfFixedDeltaTime);
+		GFrameCounter++;
+
+		FrameMs.Add((float)((FPlatformTime::Seconds() - FrameStart) * 1000.0));
+
+		Traces.Sample(FScavengerCounters::Traces.GetValue());
+		RpcBytes.Sample(FScavengerCounters::RpcBytes.GetValue());
+		for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++) RpcCalls[i].Sample(FScavengerCounters::RpcCalls[i].GetValue());
+		PeakTraces = FMath::Max(PeakTraces, Traces.Total - TracesBefore);
+	}
+
+	uint64 TotalRpcCalls = 0;
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+	{
+		const uint64 Calls = RpcCalls[i].Total;
+		if (Calls > 0) UE_LOG(LogScavenger, Display, TEXT("  %-32s %6llu"), FScavengerCounters::GetRpcName((EScavengerRpc)i), Calls);
+		TotalRpcCalls += Calls;
+	}
+
+	float TotalMs = 0.0f;
+	for (float Ms : FrameMs) TotalMs += Ms;
+	TArray<float> SortedMs = FrameMs;
+	SortedMs.Sort();
+
+	TMap<FString, float> Results;
+	Results.Add(TEXT("AvgFrameMs"), TotalMs / NumFrames);
+	Results.Add(TEXT("P95FrameMs"), SortedMs[FMath::FloorToInt(0.95f * (NumFrames - 1))]);
+	Results.Add(TEXT("TracesPerFrame"), (float)Traces.Total / NumFrames);
+	Results.Add(TEXT("PeakTracesPerFrame"), (float)PeakTraces);
+	Results.Add(TEXT("RpcsPerFrame"), (float)TotalRpcCalls / NumFrames);
+	Results.Add(TEXT("RpcBytesPerFrame"), (float)RpcBytes.Total / NumFrames);
+
+	UE_LOG(LogScavenger, Display, TEXT("%s, %d characters, %d frames:"), *MapName, Characters.Num(), NumFrames);
+	for (const TCHAR* Metric : PerfMetrics)
+	{
+		UE_LOG(LogScavenger, Display, TEXT("  %-32s %10.3f"), Metric, Results[Metric]);
+	}
+
+	TMap<FString, FBaselineEntry> Baseline;
+	const bool HaveBaseline = LoadBaseline(BaselinePath, Baseline);
+
+	if (WriteBaseline)
+	{
+		return SaveBaseline(BaselinePath, Results, Baseline) ? 0 : 2;
+	}
+
+	if (!HaveBaseline)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("No baseline at %s, run with -WriteBaseline to create one"), *BaselinePath);
+		return 2;
+	}
+
+	// A metric that has never been recorded has nothing to regress from; the run says so and checks the rest
+	const int32 Missing = CountMissingValues(Baseline);
+	if (Missing > 0)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Baseline %s has no value for %d metrics, run with -WriteBaseline to record them"), *BaselinePath, Missing);
+	}
+
+	return CompareToBaseline(Results, Baseline) > 0 ? 1 : 0;
+}
+
+UWorld* UScavengerPerfCommandlet::LoadWorld(const FString& MapName)
+{
+	// The real game instance, so map preloading and pawn class resolution run as they do in game
+	GameInstance = NewObject<UScavengerGameInstance>(GEngine);
+	GameInstance->InitializeStandalone();
+
+	FWorldContext* Context = GameInstance->GetWorldContext();
+	FString Error;
+	if (!GEngine->LoadMap(*Context, FURL(*MapName), nullptr, Error))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Failed to load %s: %s"), *MapName, *Error);
+		return nullptr;
+	}
+
+	// Nothing ticks the async loader here, finish the preload before anything is measured
+	FlushAsyncLoading();
+
+	return Context->World();
+}
+
+void UScavengerPerfCommandlet::SpawnScenario(UWorld* World, int32 NumCharacters)
+{
+	UClass* PawnClass = GameInstance->ResolveDefaultPawnClass();
+	if (!PawnClass || !PawnClass->IsChildOf(AScavengerCharacter::StaticClass()))
+	{
+		PawnClass = AScavengerCharacter::StaticClass();
+	}
+
+	UStaticMesh* WallMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+
+	// Start from the map's player start so the row lands on its floor
+	FVector Base(0.0f, 0.0f, 200.0f);
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Base = It->GetActorLocation();
+		break;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		const FVector Location = Base + FVector(0.0f, (i - NumCharacters / 2) * 500.0f, 0.0f);
+
+		// A 300 wide wall of cover straight ahead of each character
+		if (WallMesh)
+		{
+			AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(Location + FVector(150.0f, 0.0f, 0.0f), FRotator::ZeroRotator, SpawnParams);
+			if (Wall)
+			{
+				UStaticMeshComponent* WallComponent = Wall->GetStaticMeshComponent();
+				WallComponent->SetMobility(EComponentMobility::Movable);
+				WallComponent->SetStaticMesh(WallMesh);
+				WallComponent->SetWorldScale3D(FVector(0.4f, 3.0f, 2.0f));
+				WallComponent->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+				WallComponent->ComponentTags.Add(TEXT("Cover"));
+			}
+		}
+
+		AScavengerCharacter* Character = World->SpawnActor<AScavengerCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (!Character) continue;
+
+		Character->SpawnDefaultController();
+		if (Character->Controller) Character->Controller->SetControlRotation(FRotator::ZeroRotator);
+
+		// What SetupPlayerInputComponent does for a player's pawn, minus the input bindings
+		Character->MyCapsule = Character->GetCapsuleComponent();
+		Character->MyMove = Character->GetCharacterMovement();
+		Character->MyCapsule->OnComponentHit.AddDynamic(Character, &AScavengerCharacter::OnHit);
+
+		Characters.Add(Character);
+	}
+}
+
+void UScavengerPerfCommandlet::DriveScenario(int32 Frame)
+{
+	for (AScavengerCharacter* Character : Characters)
+	{
+		if (!Character || Character->IsPendingKill()) continue;
+
+		if (Frame < 60)
+		{
+			// Walk into the wall until the hold time puts us in cover
+			Character->MoveForward(1.0f);
+		}
+		else if (Frame < 120)
+		{
+			// Slide along it to the right edge
+			Character->MoveRight(1.0f);
+		}
+		else if (Frame == 120)
+		{
+			// Pop out from the edge
+			Character->LocalStartAiming();
+		}
+		else if (Frame == 170)
+		{
+			Character->LocalStopAiming();
+		}
+		else if (Frame == 180)
+		{
+			// Run in cover is a dash out of it
+			Character->StartRunning();
+		}
+		else if (Frame == 210)
+		{
+			Character->StartWalking();
+		}
+		else if (Frame < 270)
+		{
+			// Back into cover after the dash
+			Character->MoveForward(1.0f);
+		}
+		else if (Frame == 300)
+		{
+			Character->Die();
+		}
+	}
+}
+
+bool UScavengerPerfCommandlet::LoadBaseline(const FString& Path, TMap<FString, FBaselineEntry>& OutBaseline) const
+{
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *Path)) return false;
+
+	TArray<FString> Lines;
+	Contents.ParseIntoArrayLines(Lines);
+
+	// Metric=Value,Tolerance with ';' comments; an empty value keeps the tolerance for when one is recorded
+	for (FString Line : Lines)
+	{
+		Line = Line.Trim().TrimTrailing();
+		if (Line.IsEmpty() || Line.StartsWith(TEXT(";"))) continue;
+
+		FString Name, Rest;
+		if (!Line.Split(TEXT("="), &Name, &Rest)) continue;
+
+		FString Value, Tolerance;
+		if (!Rest.Split(TEXT(","), &Value, &Tolerance)) Value = Rest;
+
+		FBaselineEntry Entry;
+		Value = Value.Trim().TrimTrailing();
+		Tolerance = Tolerance.Trim().TrimTrailing();
+		Entry.HasValue = !Value.IsEmpty();
+		Entry.Value = Entry.HasValue ? FCString::Atof(*Value) : 0.0f;
+		Entry.Tolerance = Tolerance.IsEmpty() ? DefaultTolerance(Name) : FCString::Atof(*Tolerance);
+		OutBaseline.Add(Name.Trim().TrimTrailing(), Entry);
+	}
+
+	return true;
+}
+
+bool UScavengerPerfCommandlet::SaveBaseline(const FString& Path, const TMap<FString, float>& Results, const TMap<FString, FBaselineEntry>& Previous) const
+{
+	FString Contents;
+	Contents += TEXT("; Scavenger perf baseline, written by -run=ScavengerPerf -WriteBaseline\n");
+	Contents += TEXT("; Metric=Value,Tolerance where Tolerance is the allowed increase as a fraction of Value\n");
+
+	for (const TCHAR* Metric : PerfMetrics)
+	{
+		// Hand-tuned tolerances survive a rewrite
+		const FBaselineEntry* Old = Previous.Find(Metric);
+		const float Tolerance = Old ? Old->Tolerance : DefaultTolerance(Metric);
+		Contents += FString::Printf(TEXT("%s=%.3f,%.2f\n"), Metric, Results[Metric], Tolerance);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Contents, *Path))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Could not write baseline %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogScavenger, Display, TEXT("Wrote baseline %s"), *Path);
+	return true;
+}
+
+int32 UScavengerPerfCommandlet::CountMissingValues(const TMap<FString, FBaselineEntry>& Baseline) const
+{
+	int32 Missing = 0;
+	for (const TCHAR* Metric : PerfMetrics)
+	{
+		const FBaselineEntry* Entry = Baseline.Find(Metric);
+		if (Entry && Entry->HasValue) continue;
+
+		UE_LOG(LogScavenger, Warning, TEXT("  %s has no baseline value"), Metric);
+		Missing++;
+	}
+	return Missing;
+}
+
+int32 UScavengerPerfCommandlet::CompareToBaseline(const TMap<FString, float>& Results, const TMap<FString, FBaselineEntry>& Baseline) const
+{
+	int32 Regressions = 0;
+
+	for (const TCHAR* Metric : PerfMetrics)
+	{
+		const FBaselineEntry* Entry = Baseline.Find(Metric);
+		if (!Entry || !Entry->HasValue) continue;
+
+		// A little absolute slack so zero baselines don't fail on rounding
+		const float Current = Results[Metric];
+		const float Limit = Entry->Value + FMath::Max(Entry->Value * Entry->Tolerance, 0.01f);
+		if (Current > Limit)
+		{
+			UE_LOG(LogScavenger, Error, TEXT("  %s regressed: %.3f, baseline %.3f, limit %.3f"), Metric, Current, Entry->Value, Limit);
+			Regressions++;
+		}
+	}
+
+	if (Regressions == 0) UE_LOG(LogScavenger, Display, TEXT("No regressions against baseline"));
+	return Regressions;
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ScavengerPerfCommandlet.generated.h"
+
+class AScavengerCharacter;
+class UScavengerGameInstance;
+
+/**
+ * Headless performance regression check for character gameplay.
+ * Loads a map, spawns a fixed set of characters in front of cover walls and scripts them through
+ * cover entry, edge sliding, pop-out aiming, dash and death on a fixed timestep. Frame time, traces
+ * and RPC counts are compared against a checked-in baseline; any metric over tolerance fails the run.
+ * Metrics the baseline has no value for yet are reported and skipped, so a new metric or a fresh
+ * baseline passes until -WriteBaseline records it.
+ *
+ * UE4Editor-Cmd Scavenger -run=ScavengerPerf -nullrhi [-Map=/Game/Default_Test] [-Characters=8]
+ *     [-Frames=360] [-Baseline=Build/PerfBaselines/Default_Test.txt] [-WriteBaseline]
+ */
+UCLASS()
+class UScavengerPerfCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UScavengerPerfCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FBaselineEntry
+	{
+		float Value = 0.0f;
+		// Allowed increase over Value, as a fraction of it
+		float Tolerance = 0.1f;
+		bool HasValue = false;
+	};
+
+	UWorld* LoadWorld(const FString& MapName);
+	void SpawnScenario(UWorld* World, int32 NumCharacters);
+	void DriveScenario(int32 Frame);
+
+	bool LoadBaseline(const FString& Path, TMap<FString, FBaselineEntry>& OutBaseline) const;
+	bool SaveBaseline(const FString& Path, const TMap<FString, float>& Results, const TMap<FString, FBaselineEntry>& Previous) const;
+	// Metrics the baseline has no value for, logged as warnings
+	int32 CountMissingValues(const TMap<FString, FBaselineEntry>& Baseline) const;
+	int32 CompareToBaseline(const TMap<FString, float>& Results, const TMap<FString, FBaselineEntry>& Baseline) const;
+
+	UPROPERTY()
+	TArray<AScavengerCharacter*> Characters;
+
+	// Keeps the world and everything in it alive between frames
+	UPROPERTY()
+	UScavengerGameInstance* GameInstance;
+};
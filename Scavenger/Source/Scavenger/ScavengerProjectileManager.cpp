@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerProjectileManager.h"
+#include "ScavengerEffectManager.h"
+#include "ScavengerStats.h"
+#include "ScavengerWorldActor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Async/ParallelFor.h"
+#include "UnrealNetwork.h"
+
+static TAutoConsoleVariable<int32> CVarParallelBoltIntegrate(
+	TEXT("scav.Projectiles.ParallelIntegrate"),
+	256,
+	TEXT("Bolt count at which integration is split across task threads. 0 disables ParallelFor."));
+
+AScavengerProjectileManager::AScavengerProjectileManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Nothing replicates but the spawn multicast, which every client needs and which forces its own update
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 1.0f;
+
+	BoltMeshes = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("BoltMeshes"));
+	BoltMeshes->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	BoltMeshes->CastShadow = false;
+	RootComponent = BoltMeshes;
+
+	BoltMeshRef = FStringAssetReference(TEXT("/Game/Projectiles/LaserShot.LaserShot"));
+}
+
+AScavengerProjectileManager* AScavengerProjectileManager::Get(UWorld* World)
+{
+	// Clients wait for the server's copy to replicate
+	if (World && World->GetNetMode() == NM_Client) return TScavengerWorldActor<AScavengerProjectileManager>::Find(World);
+	return TScavengerWorldActor<AScavengerProjectileManager>::FindOrSpawn(World);
+}
+
+void AScavengerProjectileManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TScavengerWorldActor<AScavengerProjectileManager>::Register(this);
+
+	BoltPositions.Reserve(MaxBolts);
+	BoltPrevPositions.Reserve(MaxBolts);
+	BoltVelocities.Reserve(MaxBolts);
+	BoltOwners.Reserve(MaxBolts);
+	BoltLifetimes.Reserve(MaxBolts);
+	BoltDamage.Reserve(MaxBolts);
+	BoltSweeps.Reserve(MaxBolts);
+
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		UStaticMesh* BoltMesh = Cast<UStaticMesh>(BoltMeshRef.TryLoad());
+		if (BoltMesh) BoltMeshes->SetStaticMesh(BoltMesh);
+	}
+}
+
+void AScavengerProjectileManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TScavengerWorldActor<AScavengerProjectileManager>::Unregister(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AScavengerProjectileManager::SpawnBolt(AActor* Shooter, const FVector& Origin, const FVector& Direction, float Speed, float Lifetime, float Damage)
+{
+	if (Role < ROLE_Authority) return;
+
+	const FVector SafeDirection = Direction.GetSafeNormal();
+	AddBolt(Shooter, Origin, SafeDirection * Speed, Lifetime, Damage);
+
+	FScavengerBoltSpawn Spawn;
+	Spawn.Origin = Origin;
+	Spawn.Direction = SafeDirection;
+	Spawn.Shooter = Shooter;
+	Spawn.Speed = (uint16)FMath::Clamp(FMath::RoundToInt(Speed), 0, 65535);
+	Spawn.Lifetime = (uint8)FMath::Clamp(FMath::RoundToInt(Lifetime * 10.0f), 0, 255);
+	PendingSpawns.Add(Spawn);
+}
+
+void AScavengerProjectileManager::MulticastSpawnBolts_Implementation(const TArray<FScavengerBoltSpawn>& Spawns)
+{
+	// The server already simulates these, this is for remote clients only
+	if (Role == ROLE_Authority) return;
+
+	AScavengerEffectManager* Effects = AScavengerEffectManager::Get(GetWorld());
+
+	for (const FScavengerBoltSpawn& Spawn : Spawns)
+	{
+		AddBolt(Spawn.Shooter, Spawn.Origin, Spawn.Direction * Spawn.Speed, Spawn.Lifetime * 0.1f, 0.0f);
+		if (Effects) Effects->RequestEffect(TEXT("MuzzleFlash"), Spawn.Origin, FVector(Spawn.Direction).Rotation());
+	}
+}
+
+int32 AScavengerProjectileManager::AddBolt(AActor* Shooter, const FVector& Origin, const FVector& Velocity, float Lifetime, float Damage)
+{
+	if (BoltPositions.Num() >= MaxBolts)
+	{
+		// Oldest bolt is always at the front until the first swap-remove, close enough for a cap
+		RemoveBolt(0);
+	}
+
+	BoltPositions.Add(Origin);
+	BoltPrevPositions.Add(Origin);
+	BoltVelocities.Add(Velocity);
+	BoltOwners.Add(Shooter);
+	BoltLifetimes.Add(Lifetime);
+	BoltDamage.Add(Damage);
+	return BoltSweeps.Add(FTraceHandle());
+}
+
+void AScavengerProjectileManager::RemoveBolt(int32 Index)
+{
+	BoltPositions.RemoveAtSwap(Index, 1, false);
+	BoltPrevPositions.RemoveAtSwap(Index, 1, false);
+	BoltVelocities.RemoveAtSwap(Index, 1, false);
+	BoltOwners.RemoveAtSwap(Index, 1, false);
+	BoltLifetimes.RemoveAtSwap(Index, 1, false);
+	BoltDamage.RemoveAtSwap(Index, 1, false);
+	BoltSweeps.RemoveAtSwap(Index, 1, false);
+}
+
+void AScavengerProjectileManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Sweeps issued last frame have finished by now
+	ResolveSweeps();
+	Integrate(DeltaSeconds);
+	IssueSweeps();
+
+	if (GetNetMode() != NM_DedicatedServer) UpdateCosmetics();
+
+	if (PendingSpawns.Num() > 0)
+	{
+		MulticastSpawnBolts(PendingSpawns);
+		PendingSpawns.Reset();
+		// The multicast waits for the actor's next net update, which at its low frequency could be a second off
+		ForceNetUpdate();
+	}
+}
+
+void AScavengerProjectileManager::ResolveSweeps()
+{
+	UWorld* World = GetWorld();
+	FTraceDatum Result;
+
+	for (int32 i = BoltPositions.Num() - 1; i >= 0; i--)
+	{
+		bool Expired = BoltLifetimes[i] <= 0.0f;
+
+		if (BoltSweeps[i].IsValid() && World->QueryTraceData(BoltSweeps[i], Result))
+		{
+			for (const FHitResult& Hit : Result.OutHits)
+			{
+				if (Hit.bBlockingHit)
+				{
+					HandleImpact(i, Hit);
+					Expired = true;
+					break;
+				}
+			}
+		}
+
+		if (Expired) RemoveBolt(i);
+	}
+}
+
+void AScavengerProjectileManager::Integrate(float DeltaSeconds)
+{
+	const int32 NumBolts = BoltPositions.Num();
+	if (NumBolts == 0) return;
+
+	const FVector Gravity(0.0f, 0.0f, GetWorld()->GetGravityZ() * BoltGravityScale);
+
+	FVector* Positions = BoltPositions.GetData();
+	FVector* PrevPositions = BoltPrevPositions.GetData();
+	FVector* Velocities = BoltVelocities.GetData();
+	float* Lifetimes = BoltLifetimes.GetData();
+
+	auto Step = [=](int32 i)
+	{
+		PrevPositions[i] = Positions[i];
+		Positions[i] += Velocities[i] * DeltaSeconds + Gravity * (0.5f * DeltaSeconds * DeltaSeconds);
+		Velocities[i] += Gravity * DeltaSeconds;
+		Lifetimes[i] -= DeltaSeconds;
+	};
+
+	const int32 ParallelThreshold = CVarParallelBoltIntegrate.GetValueOnGameThread();
+	if (ParallelThreshold > 0 && NumBolts >= ParallelThreshold)
+	{
+		// Chunk the work so each task gets a cache-friendly run of bolts instead of one each
+		const int32 ChunkSize = 64;
+		const int32 NumChunks = (NumBolts + ChunkSize - 1) / ChunkSize;
+		ParallelFor(NumChunks, [=](int32 Chunk)
+		{
+			const int32 End = FMath::Min(NumBolts, (Chunk + 1) * ChunkSize);
+			for (int32 i = Chunk * ChunkSize; i < End; i++) Step(i);
+		});
+	}
+	else
+	{
+		for (int32 i = 0; i < NumBolts; i++) Step(i);
+	}
+}
+
+void AScavengerProjectileManager::IssueSweeps()
+{
+	UWorld* World = GetWorld();
+	const FCollisionShape BoltShape = FCollisionShape::MakeSphere(BoltRadius);
+	SCAV_COUNT_TRACE(BoltPositions.Num());
+
+	for (int32 i = 0; i < BoltPositions.Num(); i++)
+	{
+		FCollisionQueryParams TraceParameters(FName(TEXT("BoltSweep")), false, BoltOwners[i].Get());
+		TraceParameters.AddIgnoredActor(this);
+
+		// All sweeps for the frame go out together and run on the async trace tasks
+		BoltSweeps[i] = World->AsyncSweepByChannel(
+			EAsyncTraceType::Single,
+			BoltPrevPositions[i],
+			BoltPositions[i],
+			ECC_GameTraceChannel1,
+			BoltShape,
+			TraceParameters
+		);
+	}
+}
+
+void AScavengerProjectileManager::UpdateCosmetics()
+{
+	if (!BoltMeshes->StaticMesh) return;
+
+	const int32 NumBolts = BoltPositions.Num();
+
+	// Instance count follows bolt count; which instance draws which bolt doesn't matter
+	while (BoltMeshes->GetInstanceCount() < NumBolts) BoltMeshes->AddInstanceWorldSpace(FTransform::Identity);
+	while (BoltMeshes->GetInstanceCount() > NumBolts) BoltMeshes->RemoveInstance(BoltMeshes->GetInstanceCount() - 1);
+
+	// Adding and removing instances dirties the render state already; otherwise the last update does it once for all
+	for (int32 i = 0; i < NumBolts; i++)
+	{
+		const FTransform BoltTransform(BoltVelocities[i].Rotation(), BoltPositions[i]);
+		BoltMeshes->UpdateInstanceTransform(i, BoltTransform, true, i == NumBolts - 1);
+	}
+}
+
+void AScavengerProjectileManager::HandleImpact(int32 Index, const FHitResult& Hit)
+{
+	AActor* Shooter = BoltOwners[Index].Get();
+
+	if (Role == ROLE_Authority && Hit.GetActor() && BoltDamage[Index] > 0.0f)
+	{
+		APawn* ShooterPawn = Cast<APawn>(Shooter);
+		UGameplayStatics::ApplyPointDamage(
+			Hit.GetActor(),
+			BoltDamage[Index],
+			BoltVelocities[Index].GetSafeNormal(),
+			Hit,
+			ShooterPawn ? ShooterPawn->GetController() : nullptr,
+			Shooter,
+			UDamageType::StaticClass()
+		);
+	}
+
+	AScavengerEffectManager* Effects = AScavengerEffectManager::Get(GetWorld());
+	if (Effects) Effects->RequestEffect(TEXT("BoltImpact"), Hit.ImpactPoint, Hit.ImpactNormal.Rotation());
+}
+
+SIZE_T AScavengerProjectileManager::GetResourceSize(EResourceSizeMode::Type Mode)
+{
+	return Super::GetResourceSize(Mode) + BoltPositions.GetAllocatedSize() + BoltPrevPositions.GetAllocatedSize()
+		+ BoltVelocities.GetAllocatedSize() + BoltOwners.GetAllocatedSize() + BoltLifetimes.GetAllocatedSize()
+		+ BoltDamage.GetAllocatedSize() + BoltSweeps.GetAllocatedSize() + PendingSpawns.GetAllocatedSize();
+}
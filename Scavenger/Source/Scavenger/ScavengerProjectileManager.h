@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "ScavengerProjectileManager.generated.h"
+
+// What the server tells clients about a newly fired bolt
+USTRUCT()
+struct FScavengerBoltSpawn
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	// Character that fired it, so clients can ignore its capsule
+	UPROPERTY()
+	AActor* Shooter = nullptr;
+
+	// cm/s
+	UPROPERTY()
+	uint16 Speed = 0;
+
+	// Tenths of a second
+	UPROPERTY()
+	uint8 Lifetime = 0;
+};
+
+/**
+ * Simulates every in-flight blaster bolt in the world without an actor per bolt.
+ * Bolt state lives in parallel arrays that are integrated in one pass, swept with batched
+ * async traces, and drawn through a single instanced mesh. One manager exists per world.
+ */
+UCLASS(Config = Game, NotPlaceable)
+class SCAVENGER_API AScavengerProjectileManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerProjectileManager();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual SIZE_T GetResourceSize(EResourceSizeMode::Type Mode) override;
+
+	// Finds the manager for World, spawning it on the server if it doesn't exist yet
+	static AScavengerProjectileManager* Get(UWorld* World);
+
+	// Server only. Adds a bolt to the simulation and queues its spawn event for clients.
+	void SpawnBolt(AActor* Shooter, const FVector& Origin, const FVector& Direction, float Speed, float Lifetime, float Damage);
+
+	int32 GetNumBolts() const { return BoltPositions.Num(); }
+
+private:
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastSpawnBolts(const TArray<FScavengerBoltSpawn>& Spawns);
+
+	int32 AddBolt(AActor* Shooter, const FVector& Origin, const FVector& Velocity, float Lifetime, float Damage);
+	void RemoveBolt(int32 Index);
+
+	void ResolveSweeps();
+	void Integrate(float DeltaSeconds);
+	void IssueSweeps();
+	void UpdateCosmetics();
+
+	void HandleImpact(int32 Index, const FHitResult& Hit);
+
+	// Bolt state, one entry per bolt at the same index in every array
+	TArray<FVector> BoltPositions;
+	TArray<FVector> BoltPrevPositions;
+	TArray<FVector> BoltVelocities;
+	TArray<TWeakObjectPtr<AActor>> BoltOwners;
+	TArray<float> BoltLifetimes;
+	TArray<float> BoltDamage;
+	TArray<FTraceHandle> BoltSweeps;
+
+	// Spawns made this frame, sent as one multicast at the end of the tick
+	TArray<FScavengerBoltSpawn> PendingSpawns;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* BoltMeshes;
+
+	// Hard cap on bolts in flight, oldest are dropped past this
+	UPROPERTY(Config)
+	int32 MaxBolts = 2048;
+
+	UPROPERTY(Config)
+	float BoltRadius = 4.0f;
+
+	// Multiplier on world gravity, 0 for straight-line bolts
+	UPROPERTY(Config)
+	float BoltGravityScale = 0.0f;
+
+	UPROPERTY(Config)
+	FStringAssetReference BoltMeshRef;
+};
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerRpcLimiter.h"
+#include "ScavengerWorldActor.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerState.h"
+
+int32 AScavengerRpcLimiter::ExemptDepth = 0;
+
+namespace ScavengerRpcLimiter
+{
+	static void ReportCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		AScavengerRpcLimiter* Limiter = AScavengerRpcLimiter::Get(World);
+		if (Limiter) Limiter->Report();
+		else UE_LOG(LogScavenger, Log, TEXT("No RPC limiter, only servers have one"));
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ReportConsoleCommand(
+		TEXT("scav.RpcBudgetReport"),
+		TEXT("Logs server RPCs accepted and dropped per connection."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ReportCommand));
+}
+
+AScavengerRpcLimiter::AScavengerRpcLimiter()
+{
+	// Only closes abuse windows and forgets closed connections
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickInterval = 1.0f;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	// Unlimited until BeginPlay resolves the configured limits
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+	{
+		Rates[i] = -1.0f;
+		Bursts[i] = 0.0f;
+	}
+}
+
+AScavengerRpcLimiter* AScavengerRpcLimiter::Get(UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_Client || World->GetNetMode() == NM_Standalone) return nullptr;
+	return TScavengerWorldActor<AScavengerRpcLimiter>::FindOrSpawn(World);
+}
+
+void AScavengerRpcLimiter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TScavengerWorldActor<AScavengerRpcLimiter>::Register(this);
+
+	for (const FScavengerRpcLimit& Limit : Limits)
+	{
+		bool Found = false;
+		for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+		{
+			if (Limit.Rpc != FScavengerCounters::GetRpcName((EScavengerRpc)i)) continue;
+			Rates[i] = FMath::Max(Limit.PerSecond, 0.0f);
+			Bursts[i] = FMath::Max(Limit.Burst, 1.0f);
+			Found = true;
+		}
+		if (!Found) UE_LOG(LogScavenger, Warning, TEXT("RPC limit for unknown RPC %s ignored"), *Limit.Rpc);
+	}
+
+	WindowStart = FPlatformTime::Seconds();
+}
+
+void AScavengerRpcLimiter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TScavengerWorldActor<AScavengerRpcLimiter>::Unregister(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AScavengerRpcLimiter::Allow(const AActor* Caller, EScavengerRpc Rpc)
+{
+	const int32 Index = (int32)Rpc;
+	if (ExemptDepth > 0 || !Caller || Rates[Index] < 0.0f) return true;
+
+	// The listen server's own player has no connection to limit
+	UNetConnection* Connection = Caller->GetNetConnection();
+	if (!Connection) return true;
+
+	const double Now = FPlatformTime::Seconds();
+
+	FConnectionBudget* Budget = Connections.Find(Connection);
+	if (!Budget)
+	{
+		Budget = &Connections.Add(Connection);
+		Budget->Name = Connection->LowLevelGetRemoteAddress();
+		for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+		{
+			Budget->Tokens[i] = Bursts[i];
+			Budget->LastRefill[i] = Now;
+			Budget->Dropped[i] = 0;
+		}
+	}
+
+	float& Tokens = Budget->Tokens[Index];
+	Tokens = FMath::Min(Bursts[Index], Tokens + (float)(Now - Budget->LastRefill[Index]) * Rates[Index]);
+	Budget->LastRefill[Index] = Now;
+
+	if (Tokens >= 1.0f)
+	{
+		Tokens -= 1.0f;
+		Budget->Accepted++;
+		return true;
+	}
+
+	Budget->Dropped[Index]++;
+	Budget->WindowDropped++;
+	FScavengerCounters::RpcDropped[Index].Increment();
+	return false;
+}
+
+void AScavengerRpcLimiter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now - WindowStart < AbuseWindow) return;
+	WindowStart = Now;
+
+	for (auto It = Connections.CreateIterator(); It; ++It)
+	{
+		UNetConnection* Connection = It.Key().Get();
+		if (!Connection || Connection->State == USOCK_Closed)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		CloseWindow(Connection, It.Value());
+	}
+}
+
+void AScavengerRpcLimiter::CloseWindow(UNetConnection* Connection, FConnectionBudget& Budget)
+{
+	const int32 WindowDropped = Budget.WindowDropped;
+	Budget.WindowDropped = 0;
+	if (WindowDropped < AbuseThreshold) return;
+
+	Budget.AbusiveWindows++;
+
+	APlayerController* PlayerController = Connection->PlayerController;
+	const FString PlayerName = PlayerController && PlayerController->PlayerState ? PlayerController->PlayerState->PlayerName : FString(TEXT("?"));
+	UE_LOG(LogScavenger, Warning, TEXT("Connection %s (%s) had %d RPCs dropped in %.0fs, %d abusive windows so far"),
+		*Budget.Name, *PlayerName, WindowDropped, AbuseWindow, Budget.AbusiveWindows);
+
+	if (DisconnectAfterAbusiveWindows > 0 && Budget.AbusiveWindows >= DisconnectAfterAbusiveWindows)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Disconnecting %s (%s) for exceeding its RPC budget"), *Budget.Name, *PlayerName);
+		Connection->Close();
+	}
+}
+
+void AScavengerRpcLimiter::Report() const
+{
+	UE_LOG(LogScavenger, Log, TEXT("RPC budget, %d connections:"), Connections.Num());
+	for (const auto& Entry : Connections)
+	{
+		const FConnectionBudget& Budget = Entry.Value;
+
+		int32 Dropped = 0;
+		FString DroppedBy;
+		for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++)
+		{
+			if (Budget.Dropped[i] == 0) continue;
+			Dropped += Budget.Dropped[i];
+			DroppedBy += FString::Printf(TEXT(" %s=%d"), FScavengerCounters::GetRpcName((EScavengerRpc)i), Budget.Dropped[i]);
+		}
+
+		UE_LOG(LogScavenger, Log, TEXT("  %s: %d accepted, %d dropped, %d abusive windows%s"),
+			*Budget.Name, Budget.Accepted, Dropped, Budget.AbusiveWindows, *DroppedBy);
+	}
+}
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "ScavengerStats.h"
+#include "ScavengerRpcLimiter.generated.h"
+
+// Rate cap for one server RPC, by the name FScavengerCounters::GetRpcName gives it
+USTRUCT()
+struct FScavengerRpcLimit
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(Config)
+	FString Rpc;
+
+	// Sustained calls per second a connection may make
+	UPROPERTY(Config)
+	float PerSecond = 10.0f;
+
+	// Calls a connection may make in a burst on top of the sustained rate
+	UPROPERTY(Config)
+	float Burst = 10.0f;
+};
+
+/**
+ * Server-side budget for the RPCs clients send to their characters. Every connection gets a token
+ * bucket per RPC type, refilled at the configured rate; a call without a token is dropped before it
+ * does any work, so however fast a client sends, the work it causes per second is capped. Drops are
+ * counted per connection, and a connection that keeps hitting its caps is logged as abusive and, if
+ * configured, disconnected. Calls with no remote connection (the listen server's own player) are
+ * never limited. The engine runs a server's own call to a Server RPC through the same path as one
+ * from the client, so calls the server makes on a character itself (ending a dash, leaving cover
+ * as it moves the character, the RPCs one RPC makes on the way) are only free inside an
+ * FExemptScope, and every such call site opens one. Doesn't exist on clients.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class SCAVENGER_API AScavengerRpcLimiter : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerRpcLimiter();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Finds or spawns the limiter for World. Null on clients and in standalone games.
+	static AScavengerRpcLimiter* Get(UWorld* World);
+
+	// Takes a token for Rpc from the connection Caller is owned by, false if the call should be dropped
+	bool Allow(const AActor* Caller, EScavengerRpc Rpc);
+
+	// Logs what every connection has sent and had dropped
+	void Report() const;
+
+	// While one of these is in scope, server RPCs the game calls on its own characters aren't limited
+	struct FExemptScope
+	{
+		FExemptScope() { ExemptDepth++; }
+		~FExemptScope() { ExemptDepth--; }
+	};
+
+private:
+	struct FConnectionBudget
+	{
+		FString Name;
+		float Tokens[(int32)EScavengerRpc::Count];
+		double LastRefill[(int32)EScavengerRpc::Count];
+		int32 Accepted = 0;
+		int32 Dropped[(int32)EScavengerRpc::Count];
+		// Drops in the current abuse window, and windows in which the connection went over
+		int32 WindowDropped = 0;
+		int32 AbusiveWindows = 0;
+	};
+
+	void CloseWindow(UNetConnection* Connection, FConnectionBudget& Budget);
+
+	static int32 ExemptDepth;
+
+	TMap<TWeakObjectPtr<UNetConnection>, FConnectionBudget> Connections;
+
+	// Rate and burst per RPC, resolved from Limits
+	float Rates[(int32)EScavengerRpc::Count];
+	float Bursts[(int32)EScavengerRpc::Count];
+
+	double WindowStart = 0.0;
+
+	// RPCs without an entry aren't limited
+	UPROPERTY(Config)
+	TArray<FScavengerRpcLimit> Limits;
+
+	// Seconds over which drops are added up to judge a connection
+	UPROPERTY(Config)
+	float AbuseWindow = 5.0f;
+
+	// Drops within one window that mark a connection as abusive
+	UPROPERTY(Config)
+	int32 AbuseThreshold = 50;
+
+	// Abusive windows after which the connection is closed, 0 only ever logs
+	UPROPERTY(Config)
+	int32 DisconnectAfterAbusiveWindows = 0;
+};
@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerSkin.h"
+
+void UScavengerSkin::GetContent(TArray<FStringAssetReference>& OutAssets) const
+{
+	if (!Mesh.IsNull()) OutAssets.AddUnique(Mesh.ToStringReference());
+
+	for (const TAssetPtr<UMaterialInterface>& Material : Materials)
+	{
+		if (!Material.IsNull()) OutAssets.AddUnique(Material.ToStringReference());
+	}
+}
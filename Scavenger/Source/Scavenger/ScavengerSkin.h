@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "ScavengerSkin.generated.h"
+
+/**
+ * How a character looks. Holds only soft references, so listing a skin loads nothing until a
+ * character wearing it is in play. Every skin's mesh must use the character Blueprint's skeleton:
+ * the character keeps its one animation Blueprint and only the mesh and materials are swapped.
+ */
+UCLASS(BlueprintType)
+class SCAVENGER_API UScavengerSkin : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Skin)
+	FText DisplayName;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Skin)
+	TAssetPtr<USkeletalMesh> Mesh;
+
+	// Overrides by material slot, empty entries keep the mesh's own material
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Skin)
+	TArray<TAssetPtr<UMaterialInterface>> Materials;
+
+	// Everything that has to be resident before the skin can be worn
+	void GetContent(TArray<FStringAssetReference>& OutAssets) const;
+};
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerSkinManager.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerGameInstance.h"
+#include "ScavengerSkin.h"
+#include "ScavengerWorldActor.h"
+
+AScavengerSkinManager::AScavengerSkinManager()
+{
+	// Driven entirely by characters and load callbacks
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AScavengerSkinManager* AScavengerSkinManager::Find(UWorld* World)
+{
+	return TScavengerWorldActor<AScavengerSkinManager>::Find(World);
+}
+
+AScavengerSkinManager* AScavengerSkinManager::Get(UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_DedicatedServer) return nullptr;
+	return TScavengerWorldActor<AScavengerSkinManager>::FindOrSpawn(World);
+}
+
+int32 AScavengerSkinManager::GetNumSkins()
+{
+	return GetDefault<AScavengerSkinManager>()->Skins.Num();
+}
+
+void AScavengerSkinManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TScavengerWorldActor<AScavengerSkinManager>::Register(this);
+
+	Entries.SetNum(Skins.Num());
+	Pins.SetNum(Skins.Num());
+}
+
+void AScavengerSkinManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TScavengerWorldActor<AScavengerSkinManager>::Unregister(this);
+
+	for (int32 Slot = 0; Slot < Entries.Num(); Slot++) Unload(Slot);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+UScavengerSkin* AScavengerSkinManager::GetSkin(int32 Slot) const
+{
+	return Cast<UScavengerSkin>(Skins[Slot].ResolveObject());
+}
+
+void AScavengerSkinManager::Acquire(AScavengerCharacter* Character, int32 SkinIndex)
+{
+	const int32 Slot = SkinIndex - 1;
+	if (!Character || !Entries.IsValidIndex(Slot)) return;
+
+	FEntry& Entry = Entries[Slot];
+	Entry.Users++;
+
+	if (Entry.Loaded)
+	{
+		Character->WearSkin(GetSkin(Slot));
+		return;
+	}
+
+	Entry.Waiting.Add(Character);
+	if (!Entry.Loading) RequestLoad(Slot);
+}
+
+void AScavengerSkinManager::Release(int32 SkinIndex)
+{
+	const int32 Slot = SkinIndex - 1;
+	if (!Entries.IsValidIndex(Slot)) return;
+
+	FEntry& Entry = Entries[Slot];
+	Entry.Users = FMath::Max(Entry.Users - 1, 0);
+
+	// A skin still streaming is dropped when its load lands
+	if (Entry.Users == 0 && !Entry.Loading) Unload(Slot);
+}
+
+void AScavengerSkinManager::RequestLoad(int32 Slot)
+{
+	UScavengerGameInstance* GameInstance = UScavengerGameInstance::Get(this);
+	if (!GameInstance) return;
+
+	Entries[Slot].Loading = true;
+	Entries[Slot].Content.Reset();
+	Entries[Slot].Content.Add(Skins[Slot]);
+
+	// The skin first, its mesh and materials are only known once it's in
+	GameInstance->StreamableManager.RequestAsyncLoad(Skins[Slot], FStreamableDelegate::CreateUObject(this, &AScavengerSkinManager::OnSkinLoaded, Slot));
+}
+
+void AScavengerSkinManager::OnSkinLoaded(int32 Slot)
+{
+	FEntry& Entry = Entries[Slot];
+	UScavengerSkin* Skin = GetSkin(Slot);
+	UScavengerGameInstance* GameInstance = UScavengerGameInstance::Get(this);
+
+	if (!Skin || !GameInstance || Entry.Users == 0)
+	{
+		if (!Skin) UE_LOG(LogScavenger, Warning, TEXT("Skin %d (%s) failed to load, characters wearing it keep their default mesh"), Slot + 1, *Skins[Slot].ToString());
+		Unload(Slot);
+		return;
+	}
+
+	Skin->GetContent(Entry.Content);
+	GameInstance->StreamableManager.RequestAsyncLoad(Entry.Content, FStreamableDelegate::CreateUObject(this, &AScavengerSkinManager::OnContentLoaded, Slot));
+}
+
+void AScavengerSkinManager::OnContentLoaded(int32 Slot)
+{
+	FEntry& Entry = Entries[Slot];
+	if (Entry.Users == 0)
+	{
+		Unload(Slot);
+		return;
+	}
+
+	Entry.Loading = false;
+	Entry.Loaded = true;
+
+	Pins[Slot].Objects.Reset();
+	for (const FStringAssetReference& Asset : Entry.Content)
+	{
+		UObject* Object = Asset.ResolveObject();
+		if (Object) Pins[Slot].Objects.Add(Object);
+	}
+
+	// Only characters that haven't changed skin while this one streamed
+	UScavengerSkin* Skin = GetSkin(Slot);
+	for (const TWeakObjectPtr<AScavengerCharacter>& Character : Entry.Waiting)
+	{
+		if (Character.IsValid() && Character->GetWornSkinIndex() == Slot + 1) Character->WearSkin(Skin);
+	}
+	Entry.Waiting.Reset();
+}
+
+void AScavengerSkinManager::Unload(int32 Slot)
+{
+	FEntry& Entry = Entries[Slot];
+
+	// Dropping the pins lets the next collection take the assets, unless something else holds them
+	Pins[Slot].Objects.Reset();
+
+	// The streamable manager keeps one entry per asset however many asked for it, so anything shared
+	// with another skin or the map's preload is left for them
+	UScavengerGameInstance* GameInstance = UScavengerGameInstance::Get(this);
+	if (GameInstance)
+	{
+		for (const FStringAssetReference& Asset : Entry.Content)
+		{
+			if (!IsInUseElsewhere(Slot, Asset)) GameInstance->StreamableManager.Unload(Asset);
+		}
+	}
+
+	Entry.Content.Reset();
+	Entry.Waiting.Reset();
+	Entry.Loading = false;
+	Entry.Loaded = false;
+}
+
+bool AScavengerSkinManager::IsInUseElsewhere(int32 Slot, const FStringAssetReference& Asset) const
+{
+	for (int32 Other = 0; Other < Entries.Num(); Other++)
+	{
+		if (Other != Slot && (Entries[Other].Loading || Entries[Other].Loaded) && Entries[Other].Content.Contains(Asset)) return true;
+	}
+
+	const UScavengerGameInstance* GameInstance = UScavengerGameInstance::Get(this);
+	return GameInstance && GameInstance->IsPreloadAsset(Asset);
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "ScavengerSkinManager.generated.h"
+
+class AScavengerCharacter;
+class UScavengerSkin;
+
+// Everything one resident skin keeps loaded
+USTRUCT()
+struct FScavengerSkinPins
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+	TArray<UObject*> Objects;
+};
+
+/**
+ * Client-side loader for character skins. Characters carry only a replicated skin index; the first
+ * character wearing a skin streams the skin and its mesh and materials in asynchronously, and the
+ * character keeps its Blueprint's mesh until they arrive. Skins are reference counted by the
+ * characters in play wearing them, and unloaded once the last one leaves relevancy, so only skins
+ * actually on screen cost memory. Never exists on dedicated servers, which keep the default mesh.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class SCAVENGER_API AScavengerSkinManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AScavengerSkinManager();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Finds or spawns the manager for World. Always null on dedicated servers.
+	static AScavengerSkinManager* Get(UWorld* World);
+
+	// The manager for World if there already is one, never spawns
+	static AScavengerSkinManager* Find(UWorld* World);
+
+	// Skins characters can be given. Skin indices run from 1 to this, 0 is the Blueprint's own mesh.
+	static int32 GetNumSkins();
+
+	// Character has started wearing SkinIndex, it's dressed as soon as the skin is resident
+	void Acquire(AScavengerCharacter* Character, int32 SkinIndex);
+
+	// A character wearing SkinIndex has stopped
+	void Release(int32 SkinIndex);
+
+	// Data assets of every skin, in skin index order. Must be the same on server and clients.
+	UPROPERTY(Config)
+	TArray<FStringAssetReference> Skins;
+
+private:
+	struct FEntry
+	{
+		int32 Users = 0;
+		bool Loading = false;
+		bool Loaded = false;
+		// Characters to dress once loading finishes
+		TArray<TWeakObjectPtr<AScavengerCharacter>> Waiting;
+		// What was requested, to hand back to the streamable manager on unload
+		TArray<FStringAssetReference> Content;
+	};
+
+	UScavengerSkin* GetSkin(int32 Slot) const;
+
+	void RequestLoad(int32 Slot);
+	void OnSkinLoaded(int32 Slot);
+	void OnContentLoaded(int32 Slot);
+	void Unload(int32 Slot);
+
+	// Asset is in another skin still loading or worn, or in the map's preload
+	bool IsInUseElsewhere(int32 Slot, const FStringAssetReference& Asset) const;
+
+	TArray<FEntry> Entries;
+
+	// Hard references to resident skins, by slot, so they stay loaded while worn
+	UPROPERTY(Transient)
+	TArray<FScavengerSkinPins> Pins;
+};
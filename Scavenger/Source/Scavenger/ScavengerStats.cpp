@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerStats.h"
+
+FThreadSafeCounter FScavengerCounters::Traces;
+FThreadSafeCounter FScavengerCounters::RpcCalls[(int32)EScavengerRpc::Count];
+FThreadSafeCounter FScavengerCounters::RpcBytes;
+FThreadSafeCounter FScavengerCounters::RpcDropped[(int32)EScavengerRpc::Count];
+
+int32 FScavengerCounters::GetTotalRpcCalls()
+{
+	int32 Total = 0;
+	for (int32 i = 0; i < (int32)EScavengerRpc::Count; i++) Total += RpcCalls[i].GetValue();
+	return Total;
+}
+
+const TCHAR* FScavengerCounters::GetRpcName(EScavengerRpc Rpc)
+{
+	switch (Rpc)
+	{
+	case EScavengerRpc::StartRunning: return TEXT("StartRunning");
+	case EScavengerRpc::StartWalking: return TEXT("StartWalking");
+	case EScavengerRpc::EnterCover: return TEXT("EnterCover");
+	case EScavengerRpc::ExitCover: return TEXT("ExitCover");
+	case EScavengerRpc::StartAiming: return TEXT("StartAiming");
+	case EScavengerRpc::StopAiming: return TEXT("StopAiming");
+	case EScavengerRpc::StartDash: return TEXT("StartDash");
+	case EScavengerRpc::StopDash: return TEXT("StopDash");
+	case EScavengerRpc::Die: return TEXT("Die");
+	case EScavengerRpc::Fire: return TEXT("ServerFire");
+	case EScavengerRpc::AdjustActorLocation: return TEXT("ServerAdjustActorLocation");
+	case EScavengerRpc::SetAimPitch: return TEXT("ServerSetAimPitch");
+	case EScavengerRpc::SetAimYaw: return TEXT("ServerSetAimYaw");
+	case EScavengerRpc::SetCoverState: return TEXT("ServerSetCoverState");
+	case EScavengerRpc::ClientUpdateWalkSpeed: return TEXT("ClientUpdateWalkSpeed");
+	case EScavengerRpc::ClientUpdateEdges: return TEXT("ClientUpdateEdges");
+	case EScavengerRpc::ClientOrientRotationToMovement: return TEXT("ClientOrientRotationToMovement");
+	case EScavengerRpc::ClientResetForRound: return TEXT("ClientResetForRound");
+	default: return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Every RPC on AScavengerCharacter, for per-type counting
+enum class EScavengerRpc : uint8
+{
+	StartRunning,
+	StartWalking,
+	EnterCover,
+	ExitCover,
+	StartAiming,
+	StopAiming,
+	StartDash,
+	StopDash,
+	Die,
+	Fire,
+	AdjustActorLocation,
+	SetAimPitch,
+	SetAimYaw,
+	SetCoverState,
+	ClientUpdateWalkSpeed,
+	ClientUpdateEdges,
+	ClientOrientRotationToMovement,
+	ClientResetForRound,
+	Count
+};
+
+/**
+ * Running totals of the work gameplay code does, for the perf tools to sample.
+ * Totals only ever go up; readers keep their own previous value and take the difference.
+ * Each update is a single interlocked add, cheap enough to leave in shipping builds.
+ */
+struct SCAVENGER_API FScavengerCounters
+{
+	// Scene queries issued by gameplay code (traces, sweeps, overlaps)
+	static FThreadSafeCounter Traces;
+
+	// RPCs executed, and the approximate parameter payload they carried
+	static FThreadSafeCounter RpcCalls[(int32)EScavengerRpc::Count];
+	static FThreadSafeCounter RpcBytes;
+
+	// RPCs a server dropped for going over their connection's budget
+	static FThreadSafeCounter RpcDropped[(int32)EScavengerRpc::Count];
+
+	static void CountRpc(EScavengerRpc Rpc, int32 PayloadBytes)
+	{
+		RpcCalls[(int32)Rpc].Increment();
+		RpcBytes.Add(PayloadBytes);
+	}
+
+	static int32 GetTotalRpcCalls();
+
+	static const TCHAR* GetRpcName(EScavengerRpc Rpc);
+};
+
+/**
+ * 64-bit total of one FScavengerCounters counter, which is 32 bit and wraps. Sampled at least once
+ * a frame, the difference from the last sample is always small, so it survives the wrap.
+ */
+struct FScavengerCounterTotal
+{
+	uint32 Last = 0;
+	uint64 Total = 0;
+
+	// Counts from Value on, forgetting anything before it
+	void Reset(int32 Value)
+	{
+		Last = (uint32)Value;
+		Total = 0;
+	}
+
+	void Sample(int32 Value)
+	{
+		Total += (uint32)Value - Last;
+		Last = (uint32)Value;
+	}
+};
+
+#define SCAV_COUNT_TRACE(Num) FScavengerCounters::Traces.Add(Num)
+#define SCAV_COUNT_RPC(Rpc, PayloadBytes) FScavengerCounters::CountRpc(EScavengerRpc::Rpc, PayloadBytes)
@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerTrace.h"
+#include "ScavengerMemory.h"
+#include "GameFramework/PlayerState.h"
+
+int32 FScavengerTrace::CategoryMask = 0;
+
+static int32 GTraceBufferRecords = 16384;
+
+static FAutoConsoleVariableRef CVarTrace(
+	TEXT("scav.Trace"),
+	FScavengerTrace::CategoryMask,
+	TEXT("Gameplay trace categories to record, as a mask: 1 cover, 2 edges, 4 dash, 8 aim, 16 combat. 0 records nothing."),
+	ECVF_Default);
+
+static FAutoConsoleVariableRef CVarTraceBufferRecords(
+	TEXT("scav.TraceBufferRecords"),
+	GTraceBufferRecords,
+	TEXT("Records kept per thread, rounded up to a power of two. Applies to threads that haven't traced yet."),
+	ECVF_Default);
+
+namespace ScavengerTrace
+{
+	// One per thread that has ever traced, written only by that thread
+	struct FBuffer
+	{
+		TArray<FScavengerTraceRecord> Records;
+		// Total records written, the next one goes at Written masked to the capacity
+		uint32 Written = 0;
+		uint8 Thread = 0;
+	};
+
+	// Never freed, a thread can exit with events in its buffer that a later dump still wants
+	static TArray<FBuffer*> Buffers;
+	static FCriticalSection BuffersLock;
+
+	static FBuffer* GetThreadBuffer()
+	{
+		static const uint32 TlsSlot = FPlatformTLS::AllocTlsSlot();
+
+		FBuffer* Buffer = static_cast<FBuffer*>(FPlatformTLS::GetTlsValue(TlsSlot));
+		if (Buffer) return Buffer;
+
+		Buffer = new FBuffer;
+		Buffer->Records.SetNum(FMath::RoundUpToPowerOfTwo(FMath::Max(GTraceBufferRecords, 64)));
+		FScavengerMemory::Track(EScavengerMemoryCategory::Diagnostics, sizeof(FBuffer) + Buffer->Records.GetAllocatedSize());
+		{
+			FScopeLock Lock(&BuffersLock);
+			Buffer->Thread = (uint8)FMath::Min(Buffers.Num(), 255);
+			Buffers.Add(Buffer);
+		}
+		FPlatformTLS::SetTlsValue(TlsSlot, Buffer);
+		return Buffer;
+	}
+
+	static uint32 GetActorId(const AActor* Actor)
+	{
+		if (!Actor) return 0;
+
+		const APawn* Pawn = Cast<APawn>(Actor);
+		if (Pawn && Pawn->PlayerState) return (uint32)Pawn->PlayerState->PlayerId;
+
+		// Only meaningful on this machine, the high bit marks it as such
+		return 0x80000000u | Actor->GetUniqueID();
+	}
+
+	static void DumpCommand(const TArray<FString>& Args)
+	{
+		FScavengerTrace::Dump(Args.Num() > 0 ? Args[0] : TEXT("Manual"));
+	}
+
+	static FAutoConsoleCommand DumpConsoleCommand(
+		TEXT("scav.TraceDump"),
+		TEXT("Writes the gameplay trace to Saved/Trace. Optional argument names the dump."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpCommand));
+
+	static void OnSystemError()
+	{
+		if (FScavengerTrace::CategoryMask) FScavengerTrace::Dump(TEXT("Error"));
+	}
+
+	static void OnSystemEnsure()
+	{
+		// Once a session, an ensure in a hot path would otherwise write a file every frame
+		static bool Dumped = false;
+		if (Dumped || !FScavengerTrace::CategoryMask) return;
+		Dumped = true;
+		FScavengerTrace::Dump(TEXT("Ensure"));
+	}
+
+	struct FErrorHooks
+	{
+		FErrorHooks()
+		{
+			FCoreDelegates::OnHandleSystemError.AddStatic(&OnSystemError);
+			FCoreDelegates::OnHandleSystemEnsure.AddStatic(&OnSystemEnsure);
+		}
+	};
+	static FErrorHooks ErrorHooks;
+}
+
+using namespace ScavengerTrace;
+
+void FScavengerTrace::Record(EScavengerTraceEvent Event, const AActor* Actor, float A, float B, float C, float D)
+{
+	FBuffer* Buffer = GetThreadBuffer();
+
+	FScavengerTraceRecord& Record = Buffer->Records[Buffer->Written & (Buffer->Records.Num() - 1)];
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.ActorId = GetActorId(Actor);
+	Record.Event = (uint16)Event;
+	Record.Role = Actor ? (uint8)Actor->Role : 0;
+	Record.Thread = Buffer->Thread;
+	Record.Payload[0] = A;
+	Record.Payload[1] = B;
+	Record.Payload[2] = C;
+	Record.Payload[3] = D;
+
+	Buffer->Written++;
+}
+
+FString FScavengerTrace::Dump(const FString& Reason)
+{
+	// Other threads keep writing while this copies, so their newest record may be torn
+	TArray<FScavengerTraceRecord> Records;
+	{
+		FScopeLock Lock(&BuffersLock);
+		for (const FBuffer* Buffer : Buffers)
+		{
+			const uint32 Capacity = Buffer->Records.Num();
+			const uint32 Written = Buffer->Written;
+			const uint32 Count = FMath::Min(Written, Capacity);
+			for (uint32 i = Written - Count; i != Written; i++)
+			{
+				Records.Add(Buffer->Records[i & (Capacity - 1)]);
+			}
+		}
+	}
+	Records.Sort([](const FScavengerTraceRecord& A, const FScavengerTraceRecord& B) { return A.Cycles < B.Cycles; });
+
+	FString SafeReason = Reason;
+	for (TCHAR& Char : SafeReason.GetCharArray())
+	{
+		if (Char && !FChar::IsAlnum(Char)) Char = TEXT('_');
+	}
+
+	const FString Path = FPaths::GameSavedDir() / TEXT("Trace") / FString::Printf(TEXT("%s_%s.scavtrace"), *FDateTime::Now().ToString(), *SafeReason);
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*Path);
+	if (!Writer)
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("Couldn't write gameplay trace to %s"), *Path);
+		return FString();
+	}
+
+	FScavengerTraceFileHeader Header;
+	Header.NumRecords = Records.Num();
+	Header.NetMode = GWorld ? (uint8)GWorld->GetNetMode() : 0;
+	Header.SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+	Header.DumpCycles = FPlatformTime::Cycles64();
+	Header.DumpUtcTicks = FDateTime::UtcNow().GetTicks();
+	Header.Reason = Reason;
+
+	*Writer << Header;
+	for (FScavengerTraceRecord& Record : Records) *Writer << Record;
+	Writer->Close();
+	delete Writer;
+
+	UE_LOG(LogScavenger, Log, TEXT("Wrote %d gameplay trace records to %s"), Records.Num(), *Path);
+	return Path;
+}
+
+const TCHAR* FScavengerTrace::GetEventName(EScavengerTraceEvent Event)
+{
+	switch (Event)
+	{
+	case EScavengerTraceEvent::EnterCover: return TEXT("EnterCover");
+	case EScavengerTraceEvent::ExitCover: return TEXT("ExitCover");
+	case EScavengerTraceEvent::CoverState: return TEXT("CoverState");
+	case EScavengerTraceEvent::Edges: return TEXT("Edges");
+	case EScavengerTraceEvent::DashStart: return TEXT("DashStart");
+	case EScavengerTraceEvent::DashStop: return TEXT("DashStop");
+	case EScavengerTraceEvent::AimStart: return TEXT("AimStart");
+	case EScavengerTraceEvent::AimStop: return TEXT("AimStop");
+	case EScavengerTraceEvent::Fire: return TEXT("Fire");
+	case EScavengerTraceEvent::Death: return TEXT("Death");
+	default: return TEXT("Unknown");
+	}
+}
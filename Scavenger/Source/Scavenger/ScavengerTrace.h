@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Define as 0 to compile every SCAV_TRACE out
+#ifndef SCAV_TRACE_ENABLED
+#define SCAV_TRACE_ENABLED 1
+#endif
+
+// Bits of the scav.Trace mask
+enum class EScavengerTraceCategory : uint32
+{
+	Cover = 1 << 0,
+	Edge = 1 << 1,
+	Dash = 1 << 2,
+	Aim = 1 << 3,
+	Combat = 1 << 4,
+};
+
+// Gameplay events the trace records. Payload meaning is listed per event; unused fields are zero.
+enum class EScavengerTraceEvent : uint16
+{
+	EnterCover,		// Cover direction X, Y, Z
+	ExitCover,
+	CoverState,		// Facing right, popped out
+	Edges,			// Edge-adjusted left, right, on edge left, right
+	DashStart,		// Dash direction X, Y, Z
+	DashStop,		// Ticks dashed
+	AimStart,
+	AimStop,
+	Fire,			// Direction X, Y, Z
+	Death,
+	Count
+};
+
+// One event as stored in the ring buffers and on disk
+struct FScavengerTraceRecord
+{
+	uint64 Cycles = 0;
+	// PlayerId where there is one, so ids match between server and client traces
+	uint32 ActorId = 0;
+	uint16 Event = 0;
+	// ENetRole of the actor on the recording machine
+	uint8 Role = 0;
+	// Recording thread, in the order threads first traced
+	uint8 Thread = 0;
+	float Payload[4];
+
+	friend FArchive& operator<<(FArchive& Ar, FScavengerTraceRecord& Record)
+	{
+		Ar << Record.Cycles << Record.ActorId << Record.Event << Record.Role << Record.Thread;
+		for (float& Value : Record.Payload) Ar << Value;
+		return Ar;
+	}
+};
+
+// Start of a dump file, followed by NumRecords records oldest first
+struct FScavengerTraceFileHeader
+{
+	static const uint32 ExpectedMagic = 0x54564353; // "SCVT"
+	static const uint32 CurrentVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+	uint32 NumRecords = 0;
+	uint8 NetMode = 0;
+	double SecondsPerCycle = 0.0;
+	// Cycle counter and UTC time when the dump was taken, to put records on the wall clock
+	uint64 DumpCycles = 0;
+	int64 DumpUtcTicks = 0;
+	FString Reason;
+
+	friend FArchive& operator<<(FArchive& Ar, FScavengerTraceFileHeader& Header)
+	{
+		Ar << Header.Magic << Header.Version << Header.NumRecords << Header.NetMode;
+		Ar << Header.SecondsPerCycle << Header.DumpCycles << Header.DumpUtcTicks << Header.Reason;
+		return Ar;
+	}
+};
+
+/**
+ * Binary gameplay event trace for diagnosing cover and dash desyncs without text logging.
+ * Each thread writes fixed-size records into its own ring buffer, so recording takes no lock and
+ * allocates nothing after a thread's first event. Categories are switched on with the scav.Trace
+ * mask; a disabled category costs one load and branch at the call site. Buffers are written to
+ * Saved/Trace by scav.TraceDump or on a crash or ensure, and read back by the ScavengerTraceDecode
+ * commandlet.
+ */
+struct SCAVENGER_API FScavengerTrace
+{
+	// scav.Trace
+	static int32 CategoryMask;
+
+	static EScavengerTraceCategory GetCategory(EScavengerTraceEvent Event)
+	{
+		switch (Event)
+		{
+		case EScavengerTraceEvent::EnterCover:
+		case EScavengerTraceEvent::ExitCover:
+		case EScavengerTraceEvent::CoverState:
+			return EScavengerTraceCategory::Cover;
+		case EScavengerTraceEvent::Edges:
+			return EScavengerTraceCategory::Edge;
+		case EScavengerTraceEvent::DashStart:
+		case EScavengerTraceEvent::DashStop:
+			return EScavengerTraceCategory::Dash;
+		case EScavengerTraceEvent::AimStart:
+		case EScavengerTraceEvent::AimStop:
+			return EScavengerTraceCategory::Aim;
+		default:
+			return EScavengerTraceCategory::Combat;
+		}
+	}
+
+	static bool IsEnabled(EScavengerTraceEvent Event)
+	{
+		return (CategoryMask & (uint32)GetCategory(Event)) != 0;
+	}
+
+	static void Record(EScavengerTraceEvent Event, const AActor* Actor, float A = 0.0f, float B = 0.0f, float C = 0.0f, float D = 0.0f);
+
+	// Writes every thread's buffer to Saved/Trace, returns the file written or empty on failure
+	static FString Dump(const FString& Reason);
+
+	static const TCHAR* GetEventName(EScavengerTraceEvent Event);
+};
+
+#if SCAV_TRACE_ENABLED
+#define SCAV_TRACE(Event, Actor, ...) \
+	do { if (FScavengerTrace::IsEnabled(EScavengerTraceEvent::Event)) FScavengerTrace::Record(EScavengerTraceEvent::Event, Actor, ##__VA_ARGS__); } while (0)
+#else
+#define SCAV_TRACE(Event, Actor, ...) do { } while (0)
+#endif
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerTraceDecodeCommandlet.h"
+#include "ScavengerTrace.h"
+
+static const TCHAR* GetRoleName(uint8 Role)
+{
+	switch (Role)
+	{
+	case ROLE_SimulatedProxy: return TEXT("Simulated");
+	case ROLE_AutonomousProxy: return TEXT("Autonomous");
+	case ROLE_Authority: return TEXT("Authority");
+	default: return TEXT("None");
+	}
+}
+
+static const TCHAR* GetNetModeName(uint8 NetMode)
+{
+	switch (NetMode)
+	{
+	case NM_Standalone: return TEXT("Standalone");
+	case NM_DedicatedServer: return TEXT("DedicatedServer");
+	case NM_ListenServer: return TEXT("ListenServer");
+	case NM_Client: return TEXT("Client");
+	default: return TEXT("Unknown");
+	}
+}
+
+UScavengerTraceDecodeCommandlet::UScavengerTraceDecodeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UScavengerTraceDecodeCommandlet::Main(const FString& Params)
+{
+	FString FilePath;
+	if (!FParse::Value(*Params, TEXT("File="), FilePath))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Usage: -run=ScavengerTraceDecode -File=<dump> [-Actor=<id>] [-Events=<name,...>] [-Csv=<path>]"));
+		return 2;
+	}
+
+	FArchive* Reader = IFileManager::Get().CreateFileReader(*FilePath);
+	if (!Reader)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Couldn't open %s"), *FilePath);
+		return 2;
+	}
+
+	FScavengerTraceFileHeader Header;
+	*Reader << Header;
+	if (Header.Magic != FScavengerTraceFileHeader::ExpectedMagic || Header.Version != FScavengerTraceFileHeader::CurrentVersion)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("%s is not a version %u gameplay trace"), *FilePath, FScavengerTraceFileHeader::CurrentVersion);
+		delete Reader;
+		return 2;
+	}
+
+	TArray<FScavengerTraceRecord> Records;
+	Records.SetNum(Header.NumRecords);
+	for (FScavengerTraceRecord& Record : Records) *Reader << Record;
+	const bool Truncated = Reader->IsError();
+	delete Reader;
+
+	if (Truncated)
+	{
+		UE_LOG(LogScavenger, Error, TEXT("%s ends early, expected %u records"), *FilePath, Header.NumRecords);
+		return 2;
+	}
+
+	// Filters
+	FString ActorFilter;
+	const bool FilterActor = FParse::Value(*Params, TEXT("Actor="), ActorFilter);
+	const uint32 ActorId = FilterActor ? (uint32)FCString::Strtoui64(*ActorFilter, nullptr, 10) : 0;
+
+	TArray<bool> EventEnabled;
+	EventEnabled.Init(true, (int32)EScavengerTraceEvent::Count);
+	FString EventsFilter;
+	if (FParse::Value(*Params, TEXT("Events="), EventsFilter, false))
+	{
+		TArray<FString> Names;
+		EventsFilter.ParseIntoArray(Names, TEXT(","), true);
+		for (int32 i = 0; i < EventEnabled.Num(); i++)
+		{
+			EventEnabled[i] = Names.Contains(FScavengerTrace::GetEventName((EScavengerTraceEvent)i));
+		}
+	}
+
+	FString CsvPath;
+	const bool WriteCsv = FParse::Value(*Params, TEXT("Csv="), CsvPath);
+	FString Csv = TEXT("Seconds,UtcTime,Thread,Role,Actor,Event,A,B,C,D\n");
+
+	// Records are put on the wall clock from the moment of the dump, which both counters saw
+	const FDateTime DumpTime(Header.DumpUtcTicks);
+	UE_LOG(LogScavenger, Display, TEXT("%s: %u records, %s, dumped %s UTC (%s)"), *FilePath, Header.NumRecords,
+		GetNetModeName(Header.NetMode), *DumpTime.ToString(), *Header.Reason);
+
+	const uint64 FirstCycles = Records.Num() > 0 ? Records[0].Cycles : 0;
+	int32 Shown = 0;
+	for (const FScavengerTraceRecord& Record : Records)
+	{
+		if (FilterActor && Record.ActorId != ActorId) continue;
+		if (Record.Event >= (uint16)EScavengerTraceEvent::Count || !EventEnabled[Record.Event]) continue;
+
+		const double Seconds = (double)(Record.Cycles - FirstCycles) * Header.SecondsPerCycle;
+		const double SecondsBeforeDump = ((double)Header.DumpCycles - (double)Record.Cycles) * Header.SecondsPerCycle;
+		const FDateTime UtcTime = DumpTime - FTimespan::FromSeconds(SecondsBeforeDump);
+		const TCHAR* EventName = FScavengerTrace::GetEventName((EScavengerTraceEvent)Record.Event);
+
+		// Ids with the high bit set are local object ids rather than player ids
+		const FString Actor = (Record.ActorId & 0x80000000u)
+			? FString::Printf(TEXT("local:%u"), Record.ActorId & 0x7FFFFFFFu)
+			: FString::Printf(TEXT("%u"), Record.ActorId);
+
+		UE_LOG(LogScavenger, Display, TEXT("%12.6f  %s  t%-2u %-10s %-10s %-10s %g %g %g %g"),
+			Seconds, *UtcTime.ToString(TEXT("%H:%M:%S.%s")), Record.Thread, GetRoleName(Record.Role), *Actor, EventName,
+			Record.Payload[0], Record.Payload[1], Record.Payload[2], Record.Payload[3]);
+
+		if (WriteCsv)
+		{
+			Csv += FString::Printf(TEXT("%.6f,%s,%u,%s,%s,%s,%g,%g,%g,%g\n"),
+				Seconds, *UtcTime.ToIso8601(), Record.Thread, GetRoleName(Record.Role), *Actor, EventName,
+				Record.Payload[0], Record.Payload[1], Record.Payload[2], Record.Payload[3]);
+		}
+		Shown++;
+	}
+
+	UE_LOG(LogScavenger, Display, TEXT("%d of %u records shown"), Shown, Header.NumRecords);
+
+	if (WriteCsv && !FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		UE_LOG(LogScavenger, Error, TEXT("Couldn't write %s"), *CsvPath);
+		return 2;
+	}
+	return 0;
+}
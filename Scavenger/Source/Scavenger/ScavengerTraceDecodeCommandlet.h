@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "ScavengerTraceDecodeCommandlet.generated.h"
+
+/**
+ * Prints a gameplay trace dump written by scav.TraceDump, one event per line in time order, and
+ * optionally writes it out as CSV so a server and a client dump can be lined up side by side.
+ *
+ * UE4Editor-Cmd Scavenger -run=ScavengerTraceDecode -File=Saved/Trace/<dump>.scavtrace
+ *     [-Actor=<PlayerId>] [-Events=EnterCover,ExitCover] [-Csv=Saved/Trace/<dump>.csv]
+ */
+UCLASS()
+class UScavengerTraceDecodeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UScavengerTraceDecodeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Scavenger.h"
+#include "ScavengerWeaponComponent.h"
+#include "Gun.h"
+#include "ScavengerCharacter.h"
+#include "ScavengerGameState.h"
+#include "ScavengerHitResolver.h"
+#include "ScavengerProjectileManager.h"
+#include "ScavengerStats.h"
+
+#include "UnrealNetwork.h"
+
+UScavengerWeaponComponent::UScavengerWeaponComponent()
+{
+	// Driven by the owner when it fires, nothing to do per frame
+	PrimaryComponentTick.bCanEverTick = false;
+	bWantsBeginPlay = false;
+
+	SetIsReplicated(true);
+}
+
+void UScavengerWeaponComponent::GetLifetimeReplicatedProps(TArray< FLifetimeProperty > & OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UScavengerWeaponComponent, WeaponClass);
+	DOREPLIFETIME_CONDITION(UScavengerWeaponComponent, SpreadSalt, COND_OwnerOnly);
+}
+
+void UScavengerWeaponComponent::Equip(UClass* NewWeaponClass)
+{
+	if (NewWeaponClass && !NewWeaponClass->IsChildOf(AGun::StaticClass()))
+	{
+		UE_LOG(LogScavenger, Warning, TEXT("%s is not a weapon, %s left unarmed"), *NewWeaponClass->GetName(), *GetNameSafe(GetOwner()));
+		NewWeaponClass = nullptr;
+	}
+	if (NewWeaponClass == WeaponClass) return;
+
+	if (SpreadSalt == 0) SpreadSalt = (int32)(GetTypeHash(FGuid::NewGuid()) | 1);
+	WeaponClass = NewWeaponClass;
+	LastFireTime = -1000.0f;
+	UpdateMesh();
+}
+
+void UScavengerWeaponComponent::ResetForRound(UClass* NewWeaponClass)
+{
+	Equip(NewWeaponClass);
+	LastFireTime = -1000.0f;
+}
+
+void UScavengerWeaponComponent::OnRep_WeaponClass()
+{
+	UpdateMesh();
+}
+
+const AGun* UScavengerWeaponComponent::GetWeapon() const
+{
+	return WeaponClass ? WeaponClass->GetDefaultObject<AGun>() : nullptr;
+}
+
+void UScavengerWeaponComponent::UpdateMesh()
+{
+	if (Mesh)
+	{
+		Mesh->DestroyComponent();
+		Mesh = nullptr;
+	}
+
+	AActor* Owner = GetOwner();
+	UMeshComponent* Template = AGun::FindMeshTemplate(WeaponClass);
+	if (!Owner || !Template) return;
+
+	// Instanced from the weapon's own component so it keeps the mesh, materials and offset set up there
+	Mesh = NewObject<UMeshComponent>(Owner, Template->GetClass(), NAME_None, RF_Transient, Template);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	ACharacter* Character = Cast<ACharacter>(Owner);
+	USceneComponent* Parent = Character ? Character->GetMesh() : Owner->GetRootComponent();
+	// Relative to the socket, so the template's offset lines the grip up with the hand
+	Mesh->AttachTo(Parent, HandSocket, EAttachLocation::KeepRelativeOffset, true);
+	Mesh->RegisterComponent();
+}
+
+bool UScavengerWeaponComponent::CanFire() const
+{
+	const AGun* Weapon = GetWeapon();
+	return Weapon && GetWorld()->GetTimeSeconds() - LastFireTime >= Weapon->FireInterval;
+}
+
+FVector UScavengerWeaponComponent::GetMuzzleLocation() const
+{
+	const AGun* Weapon = GetWeapon();
+	if (Mesh && Weapon && Mesh->DoesSocketExist(Weapon->MuzzleSocket)) return Mesh->GetSocketLocation(Weapon->MuzzleSocket);
+	if (Mesh) return Mesh->GetComponentLocation();
+	return GetOwner()->GetActorLocation();
+}
+
+bool UScavengerWeaponComponent::Fire(const FVector& Origin, const FVector& Direction, uint16 ShotId)
+{
+	// Wrapping comparison, the counter rolls over every 65536 shots. Old and replayed numbers are refused.
+	const int16 ShotsAhead = (int16)(ShotId - LastShotId);
+	if (ShotsAhead <= 0) return false;
+
+	// The client knows every number's spread, so numbers are used strictly in order and a shot turned
+	// away on the refire timer still uses its number up. Skipping ahead, which an honest client only
+	// does when the RPC budget dropped its shots, puts the numbering back in step but costs a refire
+	// interval, so jumping to a number with a tight spread is never quicker than firing through.
+	LastShotId = ShotId;
+	if (ShotsAhead > 1)
+	{
+		LastFireTime = GetWorld()->GetTimeSeconds();
+		return false;
+	}
+	if (!CanFire()) return false;
+	LastFireTime = GetWorld()->GetTimeSeconds();
+
+	const AGun& Weapon = *GetWeapon();
+
+	// Spread is rebuilt here from the shot's seed, never taken from the client
+	TArray<FVector> Directions;
+	Weapon.BuildPelletPattern(Direction, GetSpreadSeed(ShotId), Directions);
+
+	if (Weapon.FiresBolts)
+	{
+		AScavengerProjectileManager* Projectiles = AScavengerProjectileManager::Get(GetWorld());
+		if (Projectiles)
+		{
+			for (const FVector& BoltDirection : Directions)
+			{
+				Projectiles->SpawnBolt(GetOwner(), Origin, BoltDirection, Weapon.BoltSpeed, Weapon.BoltLifetime, Weapon.Damage);
+			}
+		}
+	}
+	else if (Directions.Num() > 1)
+	{
+		FirePellets(Weapon, Origin, Directions);
+	}
+	else
+	{
+		FireInstantHit(Weapon, Origin, Directions[0]);
+	}
+	return true;
+}
+
+void UScavengerWeaponComponent::FirePellets(const AGun& Weapon, const FVector& Origin, const TArray<FVector>& Directions)
+{
+	APawn* Instigator = Cast<APawn>(GetOwner());
+
+	TArray<FScavengerPelletHit> Hits;
+	FScavengerHitResolver::Resolve(GetWorld(), Instigator, Origin, Directions, Weapon.Range, Hits);
+
+	// One damage event per character hit, carrying every pellet that reached it
+	TMap<AScavengerCharacter*, int32> FirstHitFor;
+	TMap<AScavengerCharacter*, int32> PelletsFor;
+	for (int32 i = 0; i < Hits.Num(); i++)
+	{
+		if (!FirstHitFor.Contains(Hits[i].Character)) FirstHitFor.Add(Hits[i].Character, i);
+		PelletsFor.FindOrAdd(Hits[i].Character)++;
+	}
+
+	AController* InstigatorController = Instigator ? Instigator->GetController() : nullptr;
+	for (const auto& Entry : PelletsFor)
+	{
+		const FScavengerPelletHit& First = Hits[FirstHitFor[Entry.Key]];
+		const FVector PelletDirection = Directions[First.Pellet];
+		FHitResult Hit(Entry.Key, Entry.Key->GetCapsuleComponent(), First.Location, -PelletDirection);
+
+		UGameplayStatics::ApplyPointDamage(Entry.Key, Weapon.Damage * Entry.Value, PelletDirection, Hit,
+			InstigatorController, GetOwner(), UDamageType::StaticClass());
+	}
+}
+
+void UScavengerWeaponComponent::FireInstantHit(const AGun& Weapon, const FVector& Origin, const FVector& Direction)
+{
+	APawn* Instigator = Cast<APawn>(GetOwner());
+
+	// The held mesh belongs to the owner, so ignoring the owner covers it too
+	FCollisionQueryParams TraceParameters(FName(TEXT("GunTrace")), false, GetOwner());
+
+	FHitResult Hit;
+	SCAV_COUNT_TRACE(1);
+	if (GetWorld()->LineTraceSingleByChannel(Hit, Origin, Origin + Direction * Weapon.Range, ECC_GameTraceChannel1, TraceParameters))
+	{
+		AController* InstigatorController = Instigator ? Instigator->GetController() : nullptr;
+
+		if (Hit.GetActor())
+		{
+			UGameplayStatics::ApplyPointDamage(Hit.GetActor(), Weapon.Damage, Direction, Hit,
+				InstigatorController, GetOwner(), UDamageType::StaticClass());
+		}
+
+		// Characters report their own hit to the combat feed when they take the damage
+		if (!Cast<AScavengerCharacter>(Hit.GetActor()))
+		{
+			AScavengerGameState* GameState = AScavengerGameState::Get(this);
+			if (GameState) GameState->AddCombatEvent(EScavengerCombatEventType::Impact, Instigator, nullptr, Hit.ImpactPoint, Hit.ImpactNormal, 0.0f);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "ScavengerWeaponComponent.generated.h"
+
+class AGun;
+
+/**
+ * The weapon a character is holding. Replicates as part of its owner, sharing the owner's channel
+ * and relevancy, instead of as an actor of its own. Stats are read from the equipped AGun class's
+ * defaults and the class's mesh is instanced straight onto the owner's hand socket.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SCAVENGER_API UScavengerWeaponComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UScavengerWeaponComponent();
+
+	// Server side. Swaps to NewWeaponClass, null leaves the owner unarmed.
+	void Equip(UClass* NewWeaponClass);
+
+	// Defaults of the equipped weapon, null when unarmed
+	const AGun* GetWeapon() const;
+
+	bool CanFire() const;
+
+	// Owning client. Numbers the next shot, so the server can turn away replayed and reordered shots.
+	uint16 TakeShotId() { return ++LocalShotId; }
+
+	// Server side. Fires shot ShotId from Origin along Direction if the refire timer allows it and the
+	// shot is the next one in order; see GetSpreadSeed for why the order matters.
+	bool Fire(const FVector& Origin, const FVector& Direction, uint16 ShotId);
+
+	// Seed of shot ShotId's spread pattern, the same on the server and the owning client once the
+	// salt has replicated, so the client can draw the pellets the server is going to fire.
+	int32 GetSpreadSeed(uint16 ShotId) const { return (int32)HashCombine((uint32)SpreadSalt, GetTypeHash(ShotId)); }
+
+	// Server side. Back to holding NewWeaponClass and ready to fire for a new round; shot numbering carries on.
+	void ResetForRound(UClass* NewWeaponClass);
+
+	// World location of the muzzle socket, or wherever the weapon is held if it has none
+	FVector GetMuzzleLocation() const;
+
+	UMeshComponent* GetMesh() const { return Mesh; }
+
+	// Socket on the owner's mesh the weapon is held at
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FName HandSocket = TEXT("RHand_Socket");
+
+private:
+	UFUNCTION()
+	void OnRep_WeaponClass();
+
+	// Rebuilds the held mesh for WeaponClass
+	void UpdateMesh();
+
+	void FireInstantHit(const AGun& Weapon, const FVector& Origin, const FVector& Direction);
+	void FirePellets(const AGun& Weapon, const FVector& Origin, const TArray<FVector>& Directions);
+
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponClass)
+	TSubclassOf<AGun> WeaponClass;
+
+	UPROPERTY(Transient)
+	UMeshComponent* Mesh = nullptr;
+
+	float LastFireTime = -1000.0f;
+
+	// Last shot numbered by the owning client, and the last one the server took
+	uint16 LocalShotId = 0;
+	uint16 LastShotId = 0;
+
+	// Random per weapon component, made by the server on first equip and only sent to the owner
+	UPROPERTY(Replicated)
+	int32 SpreadSalt = 0;
+};
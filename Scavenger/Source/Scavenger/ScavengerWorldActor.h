@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * The one actor of class T in each world, for managers looked up often enough that walking the
+ * actor list every time would show up. Instances add themselves in BeginPlay and take themselves
+ * out in EndPlay; entries are weak, so one destroyed without an EndPlay is dropped on the next lookup.
+ */
+template<typename T>
+struct TScavengerWorldActor
+{
+	// The instance in World, without spawning one
+	static T* Find(UWorld* World)
+	{
+		if (!World) return nullptr;
+
+		for (int32 i = Instances.Num() - 1; i >= 0; i--)
+		{
+			T* Instance = Instances[i].Get();
+			if (!Instance)
+			{
+				Instances.RemoveAtSwap(i);
+				continue;
+			}
+			if (Instance->GetWorld() == World) return Instance;
+		}
+		return nullptr;
+	}
+
+	// The instance in World, spawning it the first time it's asked for
+	static T* FindOrSpawn(UWorld* World)
+	{
+		T* Existing = Find(World);
+		if (Existing || !World) return Existing;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		T* Instance = World->SpawnActor<T>(SpawnParams);
+		if (Instance) Register(Instance);
+		return Instance;
+	}
+
+	static void Register(T* Instance) { Instances.AddUnique(Instance); }
+	static void Unregister(T* Instance) { Instances.Remove(Instance); }
+
+private:
+	static TArray<TWeakObjectPtr<T>> Instances;
+};
+
+template<typename T>
+TArray<TWeakObjectPtr<T>> TScavengerWorldActor<T>::Instances;